@@ -26,9 +26,35 @@
  * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
-#include "validus.h"
+#include "validusutil.h"
+#include "validusio.h"
+#include "validuskernel.h"
+#include "validusrounds.h"
+#include "validusstats.h"
 #include <string.h>
 
+/*
+ * The single-block and finalization kernels used by the core. In single-header
+ * mode they are called directly (the generic kernel, or the compact one with
+ * VALIDUS_COMPACT_KERNEL), so that the compression function is inlined into
+ * each call site, where it can be constant-folded; the kernel table, and
+ * VALIDUS_KERNEL_ENV, then only select the lanes of ::validus_hash_many.
+ * Otherwise, they are the selected kernel's.
+ */
+#if defined(VALIDUS_HEADER_ONLY) && defined(VALIDUS_COMPACT_KERNEL)
+# define VALIDUS_CORE_KERNEL()                  ((void)0)
+# define VALIDUS_CORE_PROCESS(state, blk32)     _validus_process_compact(state, blk32)
+# define VALIDUS_CORE_FINALIZE(state, hi, lo)   _validus_finalize_compact(state, hi, lo)
+#elif defined(VALIDUS_HEADER_ONLY)
+# define VALIDUS_CORE_KERNEL()                  ((void)0)
+# define VALIDUS_CORE_PROCESS(state, blk32)     _validus_process_generic(state, blk32)
+# define VALIDUS_CORE_FINALIZE(state, hi, lo)   _validus_finalize_generic(state, hi, lo)
+#else
+# define VALIDUS_CORE_KERNEL()                  const validus_kernel* kernel = _validus_kernel()
+# define VALIDUS_CORE_PROCESS(state, blk32)     kernel->process(state, blk32)
+# define VALIDUS_CORE_FINALIZE(state, hi, lo)   kernel->finalize(state, hi, lo)
+#endif
+
 void validus_init(validus_state* state)
 {
     if (!state)
@@ -43,30 +69,40 @@ void validus_init(validus_state* state)
     state->f5 = VALIDUS_INIT_5;
 }
 
+/** Accumulates the length of one append of `len` octets into the counter. */
+static inline void _validus_count(validus_state* state, size_t len)
+{
+    state->bits[1] += (validus_word)(len >> 29);
+
+    if ((state->bits[0] += (validus_word)(len << 3)) < (len << 3))
+        state->bits[1]++;
+}
+
 void validus_append(validus_state* state, const void* data, size_t len)
 {
     if (!state || !data || len == 0)
         return;
 
+    VALIDUS_CORE_KERNEL();
     const validus_word* ptr = (const validus_word*)data;
     size_t left             = len;
     size_t done             = 0;
 
-    state->bits[1] += (validus_word)(len >> 29);
-
-    if ((state->bits[0] += (validus_word)(len << 3)) < (len << 3))
-        state->bits[1]++;
+    _validus_count(state, len);
+    VALIDUS_STAT_ADD(VALIDUS_STAT_BYTES, len);
 
     while (left > 0) {
         if (left >= VALIDUS_FP_SIZE_B) {
-            _validus_process(state, ptr);
+            VALIDUS_CORE_PROCESS(state, ptr);
+            VALIDUS_STAT_ADD(VALIDUS_STAT_FULL_BLOCKS, 1);
             done += VALIDUS_FP_SIZE_B;
             ptr  += VALIDUS_FP_SIZE_O;
         } else {
+            VALIDUS_STAT_ADD(VALIDUS_STAT_PADDED_TAILS, 1);
             validus_word stk[VALIDUS_FP_SIZE_O];
             memcpy(stk, ptr, left);
             memset(((validus_octet*)stk) + left, 0, VALIDUS_FP_SIZE_B - left);
-            _validus_process(state, stk);
+            VALIDUS_CORE_PROCESS(state, stk);
             done += left;
         }
         left = len - done;
@@ -78,31 +114,312 @@ void validus_finalize(validus_state* state)
     if (!state)
         return;
 
-    validus_octet finish[VALIDUS_FP_SIZE_B] = {
-        0xAA, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-    };
+    VALIDUS_STAT_ADD(VALIDUS_STAT_FINALIZES, 1);
+
+    /* the finalization block is 0xAA, zeroes, and the counter in its last two
+     * words (most significant first); each word is stored little-endian, so
+     * the compression function reads back the counter's own value. */
+    VALIDUS_CORE_KERNEL();
+    validus_word hi = state->bits[1];
+    validus_word lo = state->bits[0];
 
     OCTETSWAP(state->bits[1], ((validus_octet*)&state->bits[1]));
     OCTETSWAP(state->bits[0], ((validus_octet*)&state->bits[0]));
 
-    memcpy(&finish[184], &state->bits[1], 4);
-    memcpy(&finish[188], &state->bits[0], 4);
+    VALIDUS_CORE_FINALIZE(state, hi, lo);
+}
+
+void _validus_hash_short(validus_state* state, const void* data, size_t len)
+{
+    VALIDUS_CORE_KERNEL();
+
+    state->f0 = VALIDUS_INIT_0;
+    state->f1 = VALIDUS_INIT_1;
+    state->f2 = VALIDUS_INIT_2;
+    state->f3 = VALIDUS_INIT_3;
+    state->f4 = VALIDUS_INIT_4;
+    state->f5 = VALIDUS_INIT_5;
+
+    VALIDUS_STAT_ADD(VALIDUS_STAT_BYTES, len);
+    VALIDUS_STAT_ADD(VALIDUS_STAT_FINALIZES, 1);
+
+    if (len == VALIDUS_FP_SIZE_B) {
+        VALIDUS_CORE_PROCESS(state, (const validus_word*)data);
+        VALIDUS_STAT_ADD(VALIDUS_STAT_FULL_BLOCKS, 1);
+    } else if (len > 0) {
+        validus_word stk[VALIDUS_FP_SIZE_O];
+        memcpy(stk, data, len);
+        memset(((validus_octet*)stk) + len, 0, VALIDUS_FP_SIZE_B - len);
+        VALIDUS_CORE_PROCESS(state, stk);
+        VALIDUS_STAT_ADD(VALIDUS_STAT_PADDED_TAILS, 1);
+    }
+
+    /* the counter of a single append of at most one block fits in the low
+     * word, so the high word is always zero. */
+    validus_word lo = (validus_word)(len << 3);
+    state->bits[1]  = 0;
+    state->bits[0]  = lo;
+    OCTETSWAP(state->bits[0], ((validus_octet*)&state->bits[0]));
+
+    VALIDUS_CORE_FINALIZE(state, 0, lo);
+}
+
+void validus_stream_init(validus_stream* stream)
+{
+    if (!stream)
+        return;
+
+    validus_init(&stream->state);
+    stream->used  = 0;
+    stream->total = 0;
+}
+
+void validus_stream_write(validus_stream* stream, const void* data, size_t len)
+{
+    if (!stream || !data || len == 0)
+        return;
+
+    VALIDUS_CORE_KERNEL();
+    const validus_octet* ptr = (const validus_octet*)data;
+
+    stream->total += len;
+    VALIDUS_STAT_ADD(VALIDUS_STAT_BYTES, len);
+
+    if (stream->used > 0) {
+        size_t take = VALIDUS_FP_SIZE_B - stream->used;
+        if (take > len)
+            take = len;
+
+        memcpy(((validus_octet*)stream->buf) + stream->used, ptr, take);
+        stream->used += take;
+        ptr          += take;
+        len          -= take;
+
+        if (stream->used < VALIDUS_FP_SIZE_B)
+            return;
+
+        VALIDUS_CORE_PROCESS(&stream->state, stream->buf);
+        VALIDUS_STAT_ADD(VALIDUS_STAT_FULL_BLOCKS, 1);
+        stream->used = 0;
+    }
+
+    while (len >= VALIDUS_FP_SIZE_B) {
+        VALIDUS_CORE_PROCESS(&stream->state, (const validus_word*)ptr);
+        VALIDUS_STAT_ADD(VALIDUS_STAT_FULL_BLOCKS, 1);
+        ptr += VALIDUS_FP_SIZE_B;
+        len -= VALIDUS_FP_SIZE_B;
+    }
+
+    if (len > 0) {
+        memcpy(stream->buf, ptr, len);
+        stream->used = len;
+    }
+}
+
+void validus_stream_finalize(validus_stream* stream)
+{
+    if (!stream)
+        return;
+
+    if (stream->used > 0) {
+        memset(((validus_octet*)stream->buf) + stream->used, 0,
+            VALIDUS_FP_SIZE_B - stream->used);
+        VALIDUS_CORE_KERNEL();
+        VALIDUS_CORE_PROCESS(&stream->state, stream->buf);
+        VALIDUS_STAT_ADD(VALIDUS_STAT_PADDED_TAILS, 1);
+        stream->used = 0;
+    }
+
+    /* count the length exactly as a single validus_append of the whole input
+     * would, so that the fingerprint matches validus_hash_mem. */
+    stream->state.bits[0] = stream->state.bits[1] = 0;
+#if SIZE_MAX < UINT64_MAX
+    uint64_t left = stream->total;
+    while (left > 0) {
+        size_t step = left > SIZE_MAX ? SIZE_MAX : (size_t)left;
+        _validus_count(&stream->state, step);
+        left -= step;
+    }
+#else
+    _validus_count(&stream->state, (size_t)stream->total);
+#endif
+
+    validus_finalize(&stream->state);
+}
+
+void validus_state_clone(validus_state* dst, const validus_state* src)
+{
+    if (!dst || !src)
+        return;
+
+    *dst = *src;
+}
+
+void validus_stream_clone(validus_stream* dst, const validus_stream* src)
+{
+    if (!dst || !src)
+        return;
+
+    dst->state = src->state;
+    dst->used  = src->used;
+    dst->total = src->total;
+
+    if (src->used > 0)
+        memcpy(dst->buf, src->buf, src->used);
+}
+
+/*
+ * Serialized layout (little-endian):
+ *
+ *   0  magic "VLDS"        4  version        5  kind (0 = state, 1 = stream)
+ *   6  partial octets (16-bit, stream only)  8  bits[0], bits[1]
+ *  16  f0..f5
+ *  40  total octets written (64-bit, stream only)
+ *  48  partial block octets (stream only)
+ */
+#define VALIDUS_SERIAL_VERSION 1
+#define VALIDUS_SERIAL_STATE   0
+#define VALIDUS_SERIAL_STREAM  1
+
+static void _validus_serialize(const validus_state* state, validus_octet* out,
+    validus_octet kind, size_t partial)
+{
+    out[0] = 'V';
+    out[1] = 'L';
+    out[2] = 'D';
+    out[3] = 'S';
+    out[4] = VALIDUS_SERIAL_VERSION;
+    out[5] = kind;
+    out[6] = (validus_octet)(partial);
+    out[7] = (validus_octet)(partial >> 8);
+
+    _validus_store32(out + 8,  state->bits[0]);
+    _validus_store32(out + 12, state->bits[1]);
+    _validus_fp_store(out + 16, state);
+}
+
+/** Validates the header of serialized data, and decodes the state and partial octet count. */
+static bool _validus_deserialize(validus_state* state, const validus_octet* in,
+    validus_octet kind, size_t* partial)
+{
+    if (in[0] != 'V' || in[1] != 'L' || in[2] != 'D' || in[3] != 'S' ||
+        in[4] != VALIDUS_SERIAL_VERSION || in[5] != kind)
+        return false;
+
+    *partial = (size_t)in[6] | ((size_t)in[7] << 8);
+
+    state->bits[0] = _validus_load32(in + 8);
+    state->bits[1] = _validus_load32(in + 12);
+    _validus_fp_load(state, in + 16);
+
+    return true;
+}
+
+size_t validus_state_serialize(const validus_state* state, void* out, size_t size)
+{
+    if (!state || !out || size < VALIDUS_STATE_SERIALIZED_SIZE)
+        return 0;
+
+    _validus_serialize(state, (validus_octet*)out, VALIDUS_SERIAL_STATE, 0);
+    return VALIDUS_STATE_SERIALIZED_SIZE;
+}
+
+bool validus_state_deserialize(validus_state* state, const void* data, size_t len)
+{
+    if (!state || !data || len != VALIDUS_STATE_SERIALIZED_SIZE)
+        return false;
+
+    validus_state tmp;
+    size_t partial = 0;
+    if (!_validus_deserialize(&tmp, (const validus_octet*)data,
+        VALIDUS_SERIAL_STATE, &partial) || partial != 0)
+        return false;
+
+    *state = tmp;
+    return true;
+}
+
+size_t validus_stream_serialize(const validus_stream* stream, void* out, size_t size)
+{
+    if (!stream || !out || stream->used >= VALIDUS_FP_SIZE_B)
+        return 0;
+
+    size_t len = VALIDUS_STATE_SERIALIZED_SIZE + 8 + stream->used;
+    if (size < len)
+        return 0;
+
+    validus_octet* ptr = (validus_octet*)out;
+    _validus_serialize(&stream->state, ptr, VALIDUS_SERIAL_STREAM, stream->used);
+    _validus_store64(ptr + 40, stream->total);
 
-    _validus_process(state, (validus_word*)&finish[0]);
+    if (stream->used > 0)
+        memcpy(ptr + 48, stream->buf, stream->used);
+
+    return len;
+}
+
+bool validus_stream_deserialize(validus_stream* stream, const void* data, size_t len)
+{
+    if (!stream || !data || len < VALIDUS_STATE_SERIALIZED_SIZE + 8)
+        return false;
+
+    const validus_octet* ptr = (const validus_octet*)data;
+    validus_state tmp;
+    size_t partial = 0;
+    if (!_validus_deserialize(&tmp, ptr, VALIDUS_SERIAL_STREAM, &partial))
+        return false;
+
+    uint64_t total = _validus_load64(ptr + 40);
+
+    /* the partial block is always what remains of the total after the
+     * complete blocks, so anything else is corrupt. */
+    if (partial != total % VALIDUS_FP_SIZE_B ||
+        len != VALIDUS_STATE_SERIALIZED_SIZE + 8 + partial)
+        return false;
+
+    stream->state = tmp;
+    stream->used  = partial;
+    stream->total = total;
+
+    if (partial > 0)
+        memcpy(stream->buf, ptr + 48, partial);
+
+    return true;
+}
+
+bool validus_hash_string(validus_state* state, const char* string)
+{
+    if (!state || !string)
+        return false;
+
+    size_t len = strnlen(string, VALIDUS_MAX_STRING);
+    if (len <= VALIDUS_FP_SIZE_B) {
+        _validus_hash_short(state, string, len);
+        return true;
+    }
+
+    validus_init(state);
+    validus_append(state, string, len);
+    validus_finalize(state);
+
+    return true;
+}
+
+bool validus_hash_mem(validus_state* state, const void* mem, size_t len)
+{
+    if (!state || !mem || len == 0)
+        return false;
+
+    if (len <= VALIDUS_FP_SIZE_B) {
+        _validus_hash_short(state, mem, len);
+        return true;
+    }
+
+    validus_init(state);
+    validus_append(state, mem, len);
+    validus_finalize(state);
+
+    return true;
 }
 
 bool validus_compare(const validus_state* one, const validus_state* two)
@@ -120,6 +437,13 @@ void _validus_process(validus_state* state, const validus_word* blk32)
     if (!state || !blk32)
         return;
 
+    VALIDUS_CORE_KERNEL();
+    VALIDUS_CORE_PROCESS(state, blk32);
+}
+
+static VALIDUS_FORCEINLINE void _validus_compress(validus_state* state,
+    const validus_word* blk32)
+{
     validus_word a = state->f0;
     validus_word b = state->f1;
     validus_word c = state->f2;
@@ -135,206 +459,60 @@ void _validus_process(validus_state* state, const validus_word* blk32)
     blk32 = stk;
 #else
     if (!WORDALIGNED(blk32)) {
+        VALIDUS_STAT_ADD(VALIDUS_STAT_UNALIGNED, 1);
         memcpy(stk, blk32, VALIDUS_FP_SIZE_B);
         blk32 = stk;
     }
 #endif
 
-    VC_0(d, c, b, a, f, e,  2,  3, blk32[47], VALIDUS_0);
-    VC_0(c, b, a, f, e, d,  7,  6, blk32[46], VALIDUS_1);
-    VC_0(b, a, f, e, d, c, 10,  9, blk32[45], VALIDUS_2);
-    VC_0(a, f, e, d, c, b, 15, 12, blk32[44], VALIDUS_3);
-    VC_0(f, e, d, c, b, a, 20, 21, blk32[43], VALIDUS_4);
-    VC_0(e, d, c, b, a, f, 25, 24, blk32[42], VALIDUS_5);
-    VC_0(d, c, b, a, f, e,  2,  3, blk32[41], VALIDUS_6);
-    VC_0(c, b, a, f, e, d,  7,  6, blk32[40], VALIDUS_7);
-    VC_0(b, a, f, e, d, c, 10,  9, blk32[39], VALIDUS_8);
-    VC_0(a, f, e, d, c, b, 15, 12, blk32[38], VALIDUS_9);
-    VC_0(f, e, d, c, b, a, 20, 21, blk32[37], VALIDUS_10);
-    VC_0(e, d, c, b, a, f, 25, 24, blk32[36], VALIDUS_11);
-    VC_0(d, c, b, a, f, e,  2,  3, blk32[35], VALIDUS_12);
-    VC_0(c, b, a, f, e, d,  7,  6, blk32[34], VALIDUS_13);
-    VC_0(b, a, f, e, d, c, 10,  9, blk32[33], VALIDUS_14);
-    VC_0(a, f, e, d, c, b, 15, 12, blk32[32], VALIDUS_15);
-    VC_0(f, e, d, c, b, a, 20, 21, blk32[31], VALIDUS_16);
-    VC_0(e, d, c, b, a, f, 25, 24, blk32[30], VALIDUS_17);
-    VC_0(d, c, b, a, f, e,  2,  3, blk32[29], VALIDUS_18);
-    VC_0(c, b, a, f, e, d,  7,  6, blk32[28], VALIDUS_19);
-    VC_0(b, a, f, e, d, c, 10,  9, blk32[27], VALIDUS_20);
-    VC_0(a, f, e, d, c, b, 15, 12, blk32[26], VALIDUS_21);
-    VC_0(f, e, d, c, b, a, 20, 21, blk32[25], VALIDUS_22);
-    VC_0(e, d, c, b, a, f, 25, 24, blk32[24], VALIDUS_23);
-    VC_0(d, c, b, a, f, e,  2,  3, blk32[ 0], VALIDUS_24);
-    VC_0(c, b, a, f, e, d,  7,  6, blk32[ 1], VALIDUS_25);
-    VC_0(b, a, f, e, d, c, 10,  9, blk32[ 2], VALIDUS_26);
-    VC_0(a, f, e, d, c, b, 15, 12, blk32[ 3], VALIDUS_27);
-    VC_0(f, e, d, c, b, a, 20, 21, blk32[ 4], VALIDUS_28);
-    VC_0(e, d, c, b, a, f, 25, 24, blk32[ 5], VALIDUS_29);
-    VC_0(d, c, b, a, f, e,  2,  3, blk32[ 6], VALIDUS_30);
-    VC_0(c, b, a, f, e, d,  7,  6, blk32[ 7], VALIDUS_31);
-    VC_0(b, a, f, e, d, c, 10,  9, blk32[ 8], VALIDUS_32);
-    VC_0(a, f, e, d, c, b, 15, 12, blk32[ 9], VALIDUS_33);
-    VC_0(f, e, d, c, b, a, 20, 21, blk32[10], VALIDUS_34);
-    VC_0(e, d, c, b, a, f, 25, 24, blk32[11], VALIDUS_35);
-    VC_0(d, c, b, a, f, e,  2,  3, blk32[12], VALIDUS_36);
-    VC_0(c, b, a, f, e, d,  7,  6, blk32[13], VALIDUS_37);
-    VC_0(b, a, f, e, d, c, 10,  9, blk32[14], VALIDUS_38);
-    VC_0(a, f, e, d, c, b, 15, 12, blk32[15], VALIDUS_39);
-    VC_0(f, e, d, c, b, a, 20, 21, blk32[16], VALIDUS_40);
-    VC_0(e, d, c, b, a, f, 25, 24, blk32[17], VALIDUS_41);
-    VC_0(d, c, b, a, f, e,  2,  3, blk32[18], VALIDUS_42);
-    VC_0(c, b, a, f, e, d,  7,  6, blk32[19], VALIDUS_43);
-    VC_0(b, a, f, e, d, c, 10,  9, blk32[20], VALIDUS_44);
-    VC_0(a, f, e, d, c, b, 15, 12, blk32[21], VALIDUS_45);
-    VC_0(f, e, d, c, b, a, 20, 21, blk32[22], VALIDUS_46);
-    VC_0(e, d, c, b, a, f, 25, 24, blk32[23], VALIDUS_47);
-
-    VC_1(d, c, b, a, f, e,  5,  4, blk32[22], VALIDUS_48);
-    VC_1(c, b, a, f, e, d, 13, 14, blk32[20], VALIDUS_49);
-    VC_1(b, a, f, e, d, c, 17, 16, blk32[18], VALIDUS_50);
-    VC_1(a, f, e, d, c, b, 22, 19, blk32[23], VALIDUS_51);
-    VC_1(f, e, d, c, b, a, 26, 23, blk32[21], VALIDUS_52);
-    VC_1(e, d, c, b, a, f, 28, 29, blk32[19], VALIDUS_53);
-    VC_1(d, c, b, a, f, e,  5,  4, blk32[16], VALIDUS_54);
-    VC_1(c, b, a, f, e, d, 13, 14, blk32[14], VALIDUS_55);
-    VC_1(b, a, f, e, d, c, 17, 16, blk32[12], VALIDUS_56);
-    VC_1(a, f, e, d, c, b, 22, 19, blk32[17], VALIDUS_57);
-    VC_1(f, e, d, c, b, a, 26, 23, blk32[15], VALIDUS_58);
-    VC_1(e, d, c, b, a, f, 28, 29, blk32[13], VALIDUS_59);
-    VC_1(d, c, b, a, f, e,  5,  4, blk32[10], VALIDUS_60);
-    VC_1(c, b, a, f, e, d, 13, 14, blk32[ 8], VALIDUS_61);
-    VC_1(b, a, f, e, d, c, 17, 16, blk32[ 6], VALIDUS_62);
-    VC_1(a, f, e, d, c, b, 22, 19, blk32[11], VALIDUS_63);
-    VC_1(f, e, d, c, b, a, 26, 23, blk32[ 9], VALIDUS_64);
-    VC_1(e, d, c, b, a, f, 28, 29, blk32[ 7], VALIDUS_65);
-    VC_1(d, c, b, a, f, e,  5,  4, blk32[ 4], VALIDUS_66);
-    VC_1(c, b, a, f, e, d, 13, 14, blk32[ 2], VALIDUS_67);
-    VC_1(b, a, f, e, d, c, 17, 16, blk32[ 0], VALIDUS_68);
-    VC_1(a, f, e, d, c, b, 22, 19, blk32[ 5], VALIDUS_69);
-    VC_1(f, e, d, c, b, a, 26, 23, blk32[ 3], VALIDUS_70);
-    VC_1(e, d, c, b, a, f, 28, 29, blk32[ 1], VALIDUS_71);
-    VC_1(d, c, b, a, f, e,  5,  4, blk32[25], VALIDUS_72);
-    VC_1(c, b, a, f, e, d, 13, 14, blk32[27], VALIDUS_73);
-    VC_1(b, a, f, e, d, c, 17, 16, blk32[29], VALIDUS_74);
-    VC_1(a, f, e, d, c, b, 22, 19, blk32[24], VALIDUS_75);
-    VC_1(f, e, d, c, b, a, 26, 23, blk32[26], VALIDUS_76);
-    VC_1(e, d, c, b, a, f, 28, 29, blk32[28], VALIDUS_77);
-    VC_1(d, c, b, a, f, e,  5,  4, blk32[31], VALIDUS_78);
-    VC_1(c, b, a, f, e, d, 13, 14, blk32[33], VALIDUS_79);
-    VC_1(b, a, f, e, d, c, 17, 16, blk32[35], VALIDUS_80);
-    VC_1(a, f, e, d, c, b, 22, 19, blk32[30], VALIDUS_81);
-    VC_1(f, e, d, c, b, a, 26, 23, blk32[32], VALIDUS_82);
-    VC_1(e, d, c, b, a, f, 28, 29, blk32[34], VALIDUS_83);
-    VC_1(d, c, b, a, f, e,  5,  4, blk32[37], VALIDUS_84);
-    VC_1(c, b, a, f, e, d, 13, 14, blk32[39], VALIDUS_85);
-    VC_1(b, a, f, e, d, c, 17, 16, blk32[41], VALIDUS_86);
-    VC_1(a, f, e, d, c, b, 22, 19, blk32[36], VALIDUS_87);
-    VC_1(f, e, d, c, b, a, 26, 23, blk32[38], VALIDUS_88);
-    VC_1(e, d, c, b, a, f, 28, 29, blk32[40], VALIDUS_89);
-    VC_1(d, c, b, a, f, e,  5,  4, blk32[43], VALIDUS_90);
-    VC_1(c, b, a, f, e, d, 13, 14, blk32[45], VALIDUS_91);
-    VC_1(b, a, f, e, d, c, 17, 16, blk32[47], VALIDUS_92);
-    VC_1(a, f, e, d, c, b, 22, 19, blk32[42], VALIDUS_93);
-    VC_1(f, e, d, c, b, a, 26, 23, blk32[44], VALIDUS_94);
-    VC_1(e, d, c, b, a, f, 28, 29, blk32[46], VALIDUS_95);
-
-    VC_2(d, c, b, a, f, e,  3,  2, blk32[ 1], VALIDUS_96);
-    VC_2(c, b, a, f, e, d,  6,  7, blk32[ 0], VALIDUS_97);
-    VC_2(b, a, f, e, d, c,  9, 10, blk32[ 3], VALIDUS_98);
-    VC_2(a, f, e, d, c, b, 12, 15, blk32[ 2], VALIDUS_99);
-    VC_2(f, e, d, c, b, a, 21, 20, blk32[ 5], VALIDUS_100);
-    VC_2(e, d, c, b, a, f, 24, 25, blk32[ 4], VALIDUS_101);
-    VC_2(d, c, b, a, f, e,  3,  2, blk32[ 7], VALIDUS_102);
-    VC_2(c, b, a, f, e, d,  6,  7, blk32[ 6], VALIDUS_103);
-    VC_2(b, a, f, e, d, c,  9, 10, blk32[ 9], VALIDUS_104);
-    VC_2(a, f, e, d, c, b, 12, 15, blk32[ 8], VALIDUS_105);
-    VC_2(f, e, d, c, b, a, 21, 20, blk32[11], VALIDUS_106);
-    VC_2(e, d, c, b, a, f, 24, 25, blk32[10], VALIDUS_107);
-    VC_2(d, c, b, a, f, e,  3,  2, blk32[13], VALIDUS_108);
-    VC_2(c, b, a, f, e, d,  6,  7, blk32[12], VALIDUS_109);
-    VC_2(b, a, f, e, d, c,  9, 10, blk32[15], VALIDUS_110);
-    VC_2(a, f, e, d, c, b, 12, 15, blk32[14], VALIDUS_111);
-    VC_2(f, e, d, c, b, a, 21, 20, blk32[17], VALIDUS_112);
-    VC_2(e, d, c, b, a, f, 24, 25, blk32[16], VALIDUS_113);
-    VC_2(d, c, b, a, f, e,  3,  2, blk32[19], VALIDUS_114);
-    VC_2(c, b, a, f, e, d,  6,  7, blk32[18], VALIDUS_115);
-    VC_2(b, a, f, e, d, c,  9, 10, blk32[21], VALIDUS_116);
-    VC_2(a, f, e, d, c, b, 12, 15, blk32[20], VALIDUS_117);
-    VC_2(f, e, d, c, b, a, 21, 20, blk32[23], VALIDUS_118);
-    VC_2(e, d, c, b, a, f, 24, 25, blk32[22], VALIDUS_119);
-    VC_2(d, c, b, a, f, e,  3,  2, blk32[46], VALIDUS_120);
-    VC_2(c, b, a, f, e, d,  6,  7, blk32[47], VALIDUS_121);
-    VC_2(b, a, f, e, d, c,  9, 10, blk32[44], VALIDUS_122);
-    VC_2(a, f, e, d, c, b, 12, 15, blk32[45], VALIDUS_123);
-    VC_2(f, e, d, c, b, a, 21, 20, blk32[42], VALIDUS_124);
-    VC_2(e, d, c, b, a, f, 24, 25, blk32[43], VALIDUS_125);
-    VC_2(d, c, b, a, f, e,  3,  2, blk32[40], VALIDUS_126);
-    VC_2(c, b, a, f, e, d,  6,  7, blk32[41], VALIDUS_127);
-    VC_2(b, a, f, e, d, c,  9, 10, blk32[38], VALIDUS_128);
-    VC_2(a, f, e, d, c, b, 12, 15, blk32[39], VALIDUS_129);
-    VC_2(f, e, d, c, b, a, 21, 20, blk32[36], VALIDUS_130);
-    VC_2(e, d, c, b, a, f, 24, 25, blk32[37], VALIDUS_131);
-    VC_2(d, c, b, a, f, e,  3,  2, blk32[34], VALIDUS_132);
-    VC_2(c, b, a, f, e, d,  6,  7, blk32[35], VALIDUS_133);
-    VC_2(b, a, f, e, d, c,  9, 10, blk32[32], VALIDUS_134);
-    VC_2(a, f, e, d, c, b, 12, 15, blk32[33], VALIDUS_135);
-    VC_2(f, e, d, c, b, a, 21, 20, blk32[30], VALIDUS_136);
-    VC_2(e, d, c, b, a, f, 24, 25, blk32[31], VALIDUS_137);
-    VC_2(d, c, b, a, f, e,  3,  2, blk32[28], VALIDUS_138);
-    VC_2(c, b, a, f, e, d,  6,  7, blk32[29], VALIDUS_139);
-    VC_2(b, a, f, e, d, c,  9, 10, blk32[26], VALIDUS_140);
-    VC_2(a, f, e, d, c, b, 12, 15, blk32[27], VALIDUS_141);
-    VC_2(f, e, d, c, b, a, 21, 20, blk32[24], VALIDUS_142);
-    VC_2(e, d, c, b, a, f, 24, 25, blk32[25], VALIDUS_143);
-
-    VC_3(d, c, b, a, f, e,  4,  5, blk32[24], VALIDUS_144);
-    VC_3(c, b, a, f, e, d, 14, 13, blk32[26], VALIDUS_145);
-    VC_3(b, a, f, e, d, c, 16, 17, blk32[28], VALIDUS_146);
-    VC_3(a, f, e, d, c, b, 19, 22, blk32[25], VALIDUS_147);
-    VC_3(f, e, d, c, b, a, 23, 26, blk32[27], VALIDUS_148);
-    VC_3(e, d, c, b, a, f, 29, 28, blk32[29], VALIDUS_149);
-    VC_3(d, c, b, a, f, e,  4,  5, blk32[30], VALIDUS_150);
-    VC_3(c, b, a, f, e, d, 14, 13, blk32[32], VALIDUS_151);
-    VC_3(b, a, f, e, d, c, 16, 17, blk32[34], VALIDUS_152);
-    VC_3(a, f, e, d, c, b, 19, 22, blk32[31], VALIDUS_153);
-    VC_3(f, e, d, c, b, a, 23, 26, blk32[33], VALIDUS_154);
-    VC_3(e, d, c, b, a, f, 29, 28, blk32[35], VALIDUS_155);
-    VC_3(d, c, b, a, f, e,  4,  5, blk32[36], VALIDUS_156);
-    VC_3(c, b, a, f, e, d, 14, 13, blk32[38], VALIDUS_157);
-    VC_3(b, a, f, e, d, c, 16, 17, blk32[40], VALIDUS_158);
-    VC_3(a, f, e, d, c, b, 19, 22, blk32[37], VALIDUS_159);
-    VC_3(f, e, d, c, b, a, 23, 26, blk32[39], VALIDUS_160);
-    VC_3(e, d, c, b, a, f, 29, 28, blk32[41], VALIDUS_161);
-    VC_3(d, c, b, a, f, e,  4,  5, blk32[42], VALIDUS_162);
-    VC_3(c, b, a, f, e, d, 14, 13, blk32[44], VALIDUS_163);
-    VC_3(b, a, f, e, d, c, 16, 17, blk32[46], VALIDUS_164);
-    VC_3(a, f, e, d, c, b, 19, 22, blk32[43], VALIDUS_165);
-    VC_3(f, e, d, c, b, a, 23, 26, blk32[45], VALIDUS_166);
-    VC_3(e, d, c, b, a, f, 29, 28, blk32[47], VALIDUS_167);
-    VC_3(d, c, b, a, f, e,  4,  5, blk32[23], VALIDUS_168);
-    VC_3(c, b, a, f, e, d, 14, 13, blk32[21], VALIDUS_169);
-    VC_3(b, a, f, e, d, c, 16, 17, blk32[19], VALIDUS_170);
-    VC_3(a, f, e, d, c, b, 19, 22, blk32[22], VALIDUS_171);
-    VC_3(f, e, d, c, b, a, 23, 26, blk32[20], VALIDUS_172);
-    VC_3(e, d, c, b, a, f, 29, 28, blk32[18], VALIDUS_173);
-    VC_3(d, c, b, a, f, e,  4,  5, blk32[17], VALIDUS_174);
-    VC_3(c, b, a, f, e, d, 14, 13, blk32[15], VALIDUS_175);
-    VC_3(b, a, f, e, d, c, 16, 17, blk32[13], VALIDUS_176);
-    VC_3(a, f, e, d, c, b, 19, 22, blk32[16], VALIDUS_177);
-    VC_3(f, e, d, c, b, a, 23, 26, blk32[14], VALIDUS_178);
-    VC_3(e, d, c, b, a, f, 29, 28, blk32[12], VALIDUS_179);
-    VC_3(d, c, b, a, f, e,  4,  5, blk32[11], VALIDUS_180);
-    VC_3(c, b, a, f, e, d, 14, 13, blk32[ 9], VALIDUS_181);
-    VC_3(b, a, f, e, d, c, 16, 17, blk32[ 7], VALIDUS_182);
-    VC_3(a, f, e, d, c, b, 19, 22, blk32[10], VALIDUS_183);
-    VC_3(f, e, d, c, b, a, 23, 26, blk32[ 8], VALIDUS_184);
-    VC_3(e, d, c, b, a, f, 29, 28, blk32[ 6], VALIDUS_185);
-    VC_3(d, c, b, a, f, e,  4,  5, blk32[ 5], VALIDUS_186);
-    VC_3(c, b, a, f, e, d, 14, 13, blk32[ 3], VALIDUS_187);
-    VC_3(b, a, f, e, d, c, 16, 17, blk32[ 1], VALIDUS_188);
-    VC_3(a, f, e, d, c, b, 19, 22, blk32[ 4], VALIDUS_189);
-    VC_3(f, e, d, c, b, a, 23, 26, blk32[ 2], VALIDUS_190);
-    VC_3(e, d, c, b, a, f, 29, 28, blk32[ 0], VALIDUS_191);
+#define _VALIDUS_R0(a, b, c, d, e, f, r1, r2, i, k) VC_0(a, b, c, d, e, f, r1, r2, blk32[i], k);
+#define _VALIDUS_R1(a, b, c, d, e, f, r1, r2, i, k) VC_1(a, b, c, d, e, f, r1, r2, blk32[i], k);
+#define _VALIDUS_R2(a, b, c, d, e, f, r1, r2, i, k) VC_2(a, b, c, d, e, f, r1, r2, blk32[i], k);
+#define _VALIDUS_R3(a, b, c, d, e, f, r1, r2, i, k) VC_3(a, b, c, d, e, f, r1, r2, blk32[i], k);
+
+    VALIDUS_ROUNDS(_VALIDUS_R0, _VALIDUS_R1, _VALIDUS_R2, _VALIDUS_R3)
+
+#undef _VALIDUS_R0
+#undef _VALIDUS_R1
+#undef _VALIDUS_R2
+#undef _VALIDUS_R3
+
+    state->f0 += a;
+    state->f1 += b;
+    state->f2 += c;
+    state->f3 += d;
+    state->f4 += e;
+    state->f5 += f;
+}
+
+/**
+ * Compresses the finalization block: word 0 is 0xAA, words 46 and 47 hold the
+ * counter, and the rest are zero, so all but three of each stage's message
+ * terms are constants.
+ */
+static VALIDUS_FORCEINLINE void _validus_compress_final(validus_state* state,
+    validus_word hi, validus_word lo)
+{
+    validus_word a = state->f0;
+    validus_word b = state->f1;
+    validus_word c = state->f2;
+    validus_word d = state->f3;
+    validus_word e = state->f4;
+    validus_word f = state->f5;
+
+#define _VALIDUS_FIN(i) ((i) == 47 ? lo : (i) == 46 ? hi : (i) == 0 ? 0xAAU : 0U)
+#define _VALIDUS_R0(a, b, c, d, e, f, r1, r2, i, k) VC_0(a, b, c, d, e, f, r1, r2, _VALIDUS_FIN(i), k);
+#define _VALIDUS_R1(a, b, c, d, e, f, r1, r2, i, k) VC_1(a, b, c, d, e, f, r1, r2, _VALIDUS_FIN(i), k);
+#define _VALIDUS_R2(a, b, c, d, e, f, r1, r2, i, k) VC_2(a, b, c, d, e, f, r1, r2, _VALIDUS_FIN(i), k);
+#define _VALIDUS_R3(a, b, c, d, e, f, r1, r2, i, k) VC_3(a, b, c, d, e, f, r1, r2, _VALIDUS_FIN(i), k);
+
+    VALIDUS_ROUNDS(_VALIDUS_R0, _VALIDUS_R1, _VALIDUS_R2, _VALIDUS_R3)
+
+#undef _VALIDUS_FIN
+#undef _VALIDUS_R0
+#undef _VALIDUS_R1
+#undef _VALIDUS_R2
+#undef _VALIDUS_R3
 
     state->f0 += a;
     state->f1 += b;
@@ -343,3 +521,134 @@ void _validus_process(validus_state* state, const validus_word* blk32)
     state->f4 += e;
     state->f5 += f;
 }
+
+void _validus_process_generic(validus_state* state, const validus_word* blk32)
+{
+    _validus_compress(state, blk32);
+}
+
+void _validus_finalize_generic(validus_state* state, validus_word hi, validus_word lo)
+{
+    _validus_compress_final(state, hi, lo);
+}
+
+/** One round of the compact kernel's schedule. */
+typedef struct {
+    validus_word hcv;   /**< Round constant. */
+    validus_octet idx;  /**< Index of the message word. */
+    validus_octet r1;   /**< First rotation amount. */
+    validus_octet r2;   /**< Second rotation amount. */
+} validus_compact_round;
+
+/** The round schedule as data, generated from the same list as the unrolled kernels. */
+static const validus_compact_round _validus_compact_rounds[VALIDUS_FP_SIZE_B] = {
+#define _VALIDUS_CR(a, b, c, d, e, f, r1, r2, i, k) {k, i, r1, r2},
+    VALIDUS_ROUNDS(_VALIDUS_CR, _VALIDUS_CR, _VALIDUS_CR, _VALIDUS_CR)
+#undef _VALIDUS_CR
+};
+
+/** Number of rounds in each stage (i.e. using each mixer). */
+#define VALIDUS_COMPACT_STAGE 48
+
+/** One round of the compact kernel, reading its parameters from `rd`. */
+#define _VALIDUS_COMPACT(M, a, b, c, d, e, f, rd)                     \
+    do {                                                              \
+        const validus_word w = blk32[(rd)->idx];                      \
+        const validus_word t = a + M(b, c, d, e, f) +                 \
+            ROL(w + (rd)->hcv, (rd)->r1);                             \
+        a = ROR(t + w, (rd)->r2);                                     \
+    } while (false)
+
+/**
+ * Six rounds of a stage. The working variables rotate with a period of six
+ * rounds in every stage, so each iteration of a stage's loop uses the same
+ * variable order, and only the schedule entries advance.
+ */
+#define _VALIDUS_COMPACT6(M, rd)                     \
+    do {                                             \
+        _VALIDUS_COMPACT(M, d, c, b, a, f, e, rd);     \
+        _VALIDUS_COMPACT(M, c, b, a, f, e, d, rd + 1); \
+        _VALIDUS_COMPACT(M, b, a, f, e, d, c, rd + 2); \
+        _VALIDUS_COMPACT(M, a, f, e, d, c, b, rd + 3); \
+        _VALIDUS_COMPACT(M, f, e, d, c, b, a, rd + 4); \
+        _VALIDUS_COMPACT(M, e, d, c, b, a, f, rd + 5); \
+    } while (false)
+
+/** Compresses one block of native-order words with the compact (looped) rounds. */
+static void _validus_compress_compact(validus_state* state, const validus_word* blk32)
+{
+    validus_word a = state->f0;
+    validus_word b = state->f1;
+    validus_word c = state->f2;
+    validus_word d = state->f3;
+    validus_word e = state->f4;
+    validus_word f = state->f5;
+
+    const validus_compact_round* rd  = _validus_compact_rounds;
+    const validus_compact_round* end = rd + VALIDUS_COMPACT_STAGE;
+
+    for (; rd < end; rd += 6)
+        _VALIDUS_COMPACT6(M0, rd);
+
+    for (end += VALIDUS_COMPACT_STAGE; rd < end; rd += 6)
+        _VALIDUS_COMPACT6(M1, rd);
+
+    for (end += VALIDUS_COMPACT_STAGE; rd < end; rd += 6)
+        _VALIDUS_COMPACT6(M2, rd);
+
+    for (end += VALIDUS_COMPACT_STAGE; rd < end; rd += 6)
+        _VALIDUS_COMPACT6(M3, rd);
+
+    state->f0 += a;
+    state->f1 += b;
+    state->f2 += c;
+    state->f3 += d;
+    state->f4 += e;
+    state->f5 += f;
+}
+
+#undef _VALIDUS_COMPACT6
+#undef _VALIDUS_COMPACT
+
+void _validus_process_compact(validus_state* state, const validus_word* blk32)
+{
+    validus_word stk[VALIDUS_FP_SIZE_O];
+
+#ifdef VALIDUS_BIG_ENDIAN
+    for(int32_t n = VALIDUS_FP_SIZE_O - 1; n >= 0; n--)
+        OCTETSWAP(stk[n], ((validus_octet*)&blk32[n]));
+    blk32 = stk;
+#else
+    if (!WORDALIGNED(blk32)) {
+        VALIDUS_STAT_ADD(VALIDUS_STAT_UNALIGNED, 1);
+        memcpy(stk, blk32, VALIDUS_FP_SIZE_B);
+        blk32 = stk;
+    }
+#endif
+
+    _validus_compress_compact(state, blk32);
+}
+
+void _validus_finalize_compact(validus_state* state, validus_word hi, validus_word lo)
+{
+    validus_word blk[VALIDUS_FP_SIZE_O] = {0xAAU};
+
+    blk[VALIDUS_FP_SIZE_O - 2] = hi;
+    blk[VALIDUS_FP_SIZE_O - 1] = lo;
+
+    _validus_compress_compact(state, blk);
+}
+
+#if defined(VALIDUS_X86)
+VALIDUS_TARGET("bmi2")
+void _validus_process_bmi2(validus_state* state, const validus_word* blk32)
+{
+    _validus_compress(state, blk32);
+}
+
+VALIDUS_TARGET("bmi2")
+void _validus_finalize_bmi2(validus_state* state, validus_word hi, validus_word lo)
+{
+    _validus_compress_final(state, hi, lo);
+}
+#endif
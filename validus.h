@@ -99,6 +99,16 @@
 # include <stdint.h>
 # include <stdbool.h>
 
+/*
+ * In single-header mode (see validusinline.h), the functions defined in
+ * validus.c are `static inline` in every translation unit that includes it.
+ */
+# if defined(VALIDUS_HEADER_ONLY)
+#  define VALIDUS_API static inline
+# else
+#  define VALIDUS_API
+# endif
+
 /**
  * @defgroup core Core
  *
@@ -133,6 +143,22 @@ typedef struct {
     validus_word f5;      /**< Fingerprint word 5. */
 } validus_state;
 
+/**
+ * @struct validus_stream
+ * @brief Represents the state of a buffered (streaming) Validus hash operation.
+ *
+ * Buffers any partial block between calls to ::validus_stream_write, so that
+ * the fingerprint does not depend upon how the input is split: it is identical
+ * to that of ::validus_append called once with the whole input.
+ */
+typedef struct {
+    validus_state state;  /**< The underlying state; holds the fingerprint after
+                               ::validus_stream_finalize. */
+    validus_word buf[48]; /**< Partial block (VALIDUS_FP_SIZE_B octets). */
+    size_t used;          /**< Number of octets in `buf`. */
+    uint64_t total;       /**< Number of octets written so far. */
+} validus_stream;
+
 /////////////////////////// function exports ///////////////////////////////////
 
 # if defined(__cplusplus)
@@ -152,7 +178,7 @@ extern "C" {
  *
  * @param state Pointer to the ::validus_state object to initialize.
  */
-void validus_init(validus_state* state);
+VALIDUS_API void validus_init(validus_state* state);
 
 /**
  * @brief Processes a block of data, accumulating the results in
@@ -165,7 +191,7 @@ void validus_init(validus_state* state);
  * @param data  Pointer to a new block of data to process.
  * @param len   Length of `data` in octets.
  */
-void validus_append(validus_state* state, const void* data, size_t len);
+VALIDUS_API void validus_append(validus_state* state, const void* data, size_t len);
 
 /**
  * @brief Finalizes a Validus hashing operation.
@@ -175,7 +201,125 @@ void validus_append(validus_state* state, const void* data, size_t len);
  *
  * @param state Pointer to the validus_state object to finalize.
  */
-void validus_finalize(validus_state* state);
+VALIDUS_API void validus_finalize(validus_state* state);
+
+/**
+ * @brief Initializes a validus_stream object.
+ *
+ * @note If `stream` is NULL, this function will return early, and have no effect.
+ *
+ * @param stream Pointer to the ::validus_stream object to initialize.
+ */
+VALIDUS_API void validus_stream_init(validus_stream* stream);
+
+/**
+ * @brief Writes data of any length to a validus_stream.
+ *
+ * Complete blocks are processed directly from `data`; only the octets of a
+ * trailing partial block are copied, and they are held until more data
+ * arrives, or ::validus_stream_finalize is called.
+ *
+ * @note If `stream` or `data` are NULL, or `len` is zero, this function will
+ * return early, and have no effect.
+ *
+ * @param stream Pointer to the validus_stream object in use for this series of data.
+ * @param data   Pointer to the data to process.
+ * @param len    Length of `data` in octets.
+ */
+VALIDUS_API void validus_stream_write(validus_stream* stream, const void* data, size_t len);
+
+/**
+ * @brief Finalizes a streaming Validus hashing operation.
+ *
+ * Processes any buffered partial block, then finalizes `stream->state`, which
+ * thereafter contains the fingerprint.
+ *
+ * @note If `stream` is NULL, this function will return early and have no effect.
+ *
+ * @param stream Pointer to the validus_stream object to finalize.
+ */
+VALIDUS_API void validus_stream_finalize(validus_stream* stream);
+
+/**
+ * @brief Copies an in-progress (or finalized) validus_state.
+ *
+ * Allows a common prefix to be hashed once, and its midstate reused as the
+ * starting point for any number of messages.
+ *
+ * @note If `dst` or `src` are NULL, this function will return early, and have no effect.
+ *
+ * @param dst Pointer to the validus_state object to receive the copy.
+ * @param src Pointer to the validus_state object to copy.
+ */
+VALIDUS_API void validus_state_clone(validus_state* dst, const validus_state* src);
+
+/**
+ * @brief Copies an in-progress validus_stream, including its partial block.
+ *
+ * Only the buffered octets of the partial block are copied, so the cost does
+ * not depend upon the length of the prefix.
+ *
+ * @note If `dst` or `src` are NULL, this function will return early, and have no effect.
+ *
+ * @param dst Pointer to the validus_stream object to receive the copy.
+ * @param src Pointer to the validus_stream object to copy.
+ */
+VALIDUS_API void validus_stream_clone(validus_stream* dst, const validus_stream* src);
+
+/**
+ * @brief Serializes a validus_state into a portable, versioned byte format.
+ *
+ * The output is ::VALIDUS_STATE_SERIALIZED_SIZE octets, little-endian, and
+ * includes the 64-bit counter, so it may be stored or sent to another host and
+ * resumed there with ::validus_state_deserialize.
+ *
+ * @param   state  Pointer to the validus_state object to serialize.
+ * @param   out    Buffer to receive the serialized state.
+ * @param   size   Size of `out` in octets.
+ * @returns size_t The number of octets written, or zero if input parameters are
+ *                 invalid, or `out` is too small.
+ */
+VALIDUS_API size_t validus_state_serialize(const validus_state* state, void* out, size_t size);
+
+/**
+ * @brief Restores a validus_state serialized by ::validus_state_serialize.
+ *
+ * @param   state Pointer to the validus_state object to restore into.
+ * @param   data  The serialized state.
+ * @param   len   Length of `data` in octets.
+ * @returns bool  `true` if `data` is a valid serialized state, `false` otherwise
+ *                (in which case `state` is left unmodified).
+ */
+VALIDUS_API bool validus_state_deserialize(validus_state* state, const void* data, size_t len);
+
+/**
+ * @brief Serializes a validus_stream, including its partial block.
+ *
+ * The output is the serialized state, followed by the number of octets
+ * written so far and the buffered octets; it is at most
+ * ::VALIDUS_STREAM_SERIALIZED_MAX octets.
+ *
+ * @param   stream Pointer to the validus_stream object to serialize.
+ * @param   out    Buffer to receive the serialized stream.
+ * @param   size   Size of `out` in octets.
+ * @returns size_t The number of octets written, or zero if input parameters are
+ *                 invalid, or `out` is too small.
+ */
+VALIDUS_API size_t validus_stream_serialize(const validus_stream* stream, void* out, size_t size);
+
+/**
+ * @brief Restores a validus_stream serialized by ::validus_stream_serialize.
+ *
+ * Writing the remainder of the input to the restored stream yields the same
+ * fingerprint as writing the whole input to a single stream.
+ *
+ * @param   stream Pointer to the validus_stream object to restore into.
+ * @param   data   The serialized stream.
+ * @param   len    Length of `data` in octets.
+ * @returns bool   `true` if `data` is a valid serialized stream, `false` otherwise
+ *                 (in which case `stream` is left unmodified).
+ */
+VALIDUS_API bool validus_stream_deserialize(validus_stream* stream, const void* data, size_t len);
 
 /**
  * @brief Compares two validus_state objects for equality.
@@ -184,7 +328,40 @@ void validus_finalize(validus_state* state);
  * @param   two  Pointer to a validus_state to compare for equality.
  * @returns bool `true` if both states are identical, `false` otherwise.
  */
-bool validus_compare(const validus_state *one, const validus_state *two);
+VALIDUS_API bool validus_compare(const validus_state *one, const validus_state *two);
+
+/**
+ * @brief Hashes many independent messages at once.
+ *
+ * Equivalent to calling ::validus_init, ::validus_append and ::validus_finalize
+ * for each message in turn, but on CPUs with SSE4.1, AVX2 or AVX-512, up to 16
+ * messages are compressed in parallel (one per vector lane). Messages may
+ * differ in length; the fingerprints are identical to those of the scalar path.
+ *
+ * @note Best suited to large numbers of small messages; a single long message
+ * gains nothing over ::validus_append.
+ *
+ * @param   states Array of `count` validus_state objects that receive the
+ *                 finalized fingerprint of the corresponding message.
+ * @param   data   Array of `count` pointers to the messages.
+ * @param   lens   Array of `count` message lengths, in octets. A length of zero
+ *                 is permitted, and yields the fingerprint of empty input.
+ * @param   count  The number of messages.
+ * @returns bool   `true` if input parameters are valid, `false` otherwise.
+ */
+bool validus_hash_many(validus_state* states, const void* const* data,
+    const size_t* lens, size_t count);
+
+/**
+ * @brief Returns the name of the compression kernel in use.
+ *
+ * The kernel is selected once per process: the fastest one supported by the
+ * host CPU (e.g. `"avx512"`, `"avx2"`, `"bmi2"`, `"sse41"` or `"generic"`),
+ * unless the `VALIDUS_KERNEL` environment variable names a supported kernel.
+ *
+ * @returns const char* The name of the active kernel.
+ */
+const char* validus_kernel_name(void);
 
 /**
  * @brief Processes a 192-bit block of data, accumulating the results
@@ -196,7 +373,23 @@ bool validus_compare(const validus_state *one, const validus_state *two);
  * @param state Pointer to the validus_state object in use for this series of data.
  * @param blk32 Pointer to the block of data to be processed.
  */
-void _validus_process(validus_state* state, const validus_word* blk32);
+VALIDUS_API void _validus_process(validus_state* state, const validus_word* blk32);
+
+/**
+ * @brief Hashes an input of at most one block in a single call.
+ *
+ * Produces the same fingerprint as ::validus_init, ::validus_append and
+ * ::validus_finalize, but performs no argument checks, looks the kernel up
+ * once, and compresses the finalization block with its constant words folded.
+ *
+ * @attention This function is only called by other Validus functions; do not
+ * call it directly.
+ *
+ * @param state Pointer to the validus_state object to receive the fingerprint.
+ * @param data  Pointer to the input (may be NULL if `len` is zero).
+ * @param len   Length of `data` in octets; at most VALIDUS_FP_SIZE_B.
+ */
+VALIDUS_API void _validus_hash_short(validus_state* state, const void* data, size_t len);
 
 # if defined(__cplusplus)
 }
@@ -223,6 +416,12 @@ void _validus_process(validus_state* state, const validus_word* blk32);
 /** The size of a Validus fingerprint, in octets. */
 # define VALIDUS_FP_SIZE_O 48
 
+/** The size of a serialized validus_state, in octets. */
+# define VALIDUS_STATE_SERIALIZED_SIZE 40
+
+/** The maximum size of a serialized validus_stream, in octets. */
+# define VALIDUS_STREAM_SERIALIZED_MAX (VALIDUS_STATE_SERIALIZED_SIZE + 8 + VALIDUS_FP_SIZE_B)
+
 /** Determines if address `addr` is aligned on 4-byte boundaries. */
 # define WORDALIGNED(addr) (((uintptr_t)(addr) & 0x3) == 0)
 
@@ -0,0 +1,218 @@
+/**
+ * @file validus.hpp
+ * @brief Compile-time (constexpr) Validus fingerprints for C++20.
+ *
+ * Reimplements the mixers and compression rounds as `constexpr` functions, so
+ * that fingerprints of constant strings (message type names, configuration
+ * keys, ...) are computed by the compiler, and may be used as `case` labels or
+ * template arguments. The rounds are generated from the same schedule as the C
+ * kernels, and the fingerprints are identical to those of ::validus_hash_mem.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _VALIDUS_HPP_INCLUDED
+# define _VALIDUS_HPP_INCLUDED
+
+# include "validus.h"
+# include "validusrounds.h"
+# include <array>
+# include <bit>
+# include <cstddef>
+# include <cstdint>
+# include <string_view>
+
+namespace validus {
+
+/** A Validus fingerprint. A structural type, so it may be a template argument. */
+struct fp {
+    validus_word f0; /**< Fingerprint word 0. */
+    validus_word f1; /**< Fingerprint word 1. */
+    validus_word f2; /**< Fingerprint word 2. */
+    validus_word f3; /**< Fingerprint word 3. */
+    validus_word f4; /**< Fingerprint word 4. */
+    validus_word f5; /**< Fingerprint word 5. */
+
+    constexpr bool operator==(const fp&) const noexcept = default;
+
+    /** The first 64 bits of the fingerprint, for use as a `switch`/`case` key. */
+    constexpr std::uint64_t key() const noexcept
+    {
+        return (static_cast<std::uint64_t>(f0) << 32) | f1;
+    }
+
+    /** Converts to a validus_state, for use with the C API (e.g. ::validus_compare). */
+    constexpr validus_state state() const noexcept
+    {
+        return validus_state{{0, 0}, f0, f1, f2, f3, f4, f5};
+    }
+};
+
+namespace detail {
+
+/** A message block, as the compression function reads it. */
+using block = std::array<validus_word, VALIDUS_FP_SIZE_O>;
+
+/** Mixer function 0. */
+constexpr validus_word m0(validus_word a, validus_word b, validus_word c,
+    validus_word d, validus_word e) noexcept
+{
+    return (a & b) ^ ((c & d) ^ e);
+}
+
+/** Mixer function 1. */
+constexpr validus_word m1(validus_word a, validus_word b, validus_word c,
+    validus_word d, validus_word e) noexcept
+{
+    return (a & b) ^ (b ^ (c & d) ^ e);
+}
+
+/** Mixer function 2. */
+constexpr validus_word m2(validus_word a, validus_word b, validus_word c,
+    validus_word d, validus_word e) noexcept
+{
+    return (a & (b ^ c)) ^ (~d & e) ^ c;
+}
+
+/** Mixer function 3. */
+constexpr validus_word m3(validus_word a, validus_word b, validus_word c,
+    validus_word d, validus_word e) noexcept
+{
+    return (a & b) ^ (c & (d ^ e)) ^ e;
+}
+
+/** The round common to all four compression functions, given the mixer output. */
+constexpr void round(validus_word& a, validus_word mix, int r1, int r2,
+    validus_word blk, validus_word hcv) noexcept
+{
+    const validus_word t = a + mix + std::rotl(blk + hcv, r1);
+    a = std::rotr(t + blk, r2);
+}
+
+/** Compression function 0. */
+constexpr void vc0(validus_word& a, validus_word b, validus_word c, validus_word d,
+    validus_word e, validus_word f, int r1, int r2, validus_word blk, validus_word hcv) noexcept
+{
+    round(a, m0(b, c, d, e, f), r1, r2, blk, hcv);
+}
+
+/** Compression function 1. */
+constexpr void vc1(validus_word& a, validus_word b, validus_word c, validus_word d,
+    validus_word e, validus_word f, int r1, int r2, validus_word blk, validus_word hcv) noexcept
+{
+    round(a, m1(b, c, d, e, f), r1, r2, blk, hcv);
+}
+
+/** Compression function 2. */
+constexpr void vc2(validus_word& a, validus_word b, validus_word c, validus_word d,
+    validus_word e, validus_word f, int r1, int r2, validus_word blk, validus_word hcv) noexcept
+{
+    round(a, m2(b, c, d, e, f), r1, r2, blk, hcv);
+}
+
+/** Compression function 3. */
+constexpr void vc3(validus_word& a, validus_word b, validus_word c, validus_word d,
+    validus_word e, validus_word f, int r1, int r2, validus_word blk, validus_word hcv) noexcept
+{
+    round(a, m3(b, c, d, e, f), r1, r2, blk, hcv);
+}
+
+/** Compresses one block into `state`. */
+constexpr void compress(fp& state, const block& blk) noexcept
+{
+    validus_word a = state.f0;
+    validus_word b = state.f1;
+    validus_word c = state.f2;
+    validus_word d = state.f3;
+    validus_word e = state.f4;
+    validus_word f = state.f5;
+
+#define _VALIDUS_CX_R0(a, b, c, d, e, f, r1, r2, i, k) vc0(a, b, c, d, e, f, r1, r2, blk[i], k);
+#define _VALIDUS_CX_R1(a, b, c, d, e, f, r1, r2, i, k) vc1(a, b, c, d, e, f, r1, r2, blk[i], k);
+#define _VALIDUS_CX_R2(a, b, c, d, e, f, r1, r2, i, k) vc2(a, b, c, d, e, f, r1, r2, blk[i], k);
+#define _VALIDUS_CX_R3(a, b, c, d, e, f, r1, r2, i, k) vc3(a, b, c, d, e, f, r1, r2, blk[i], k);
+
+    VALIDUS_ROUNDS(_VALIDUS_CX_R0, _VALIDUS_CX_R1, _VALIDUS_CX_R2, _VALIDUS_CX_R3)
+
+#undef _VALIDUS_CX_R0
+#undef _VALIDUS_CX_R1
+#undef _VALIDUS_CX_R2
+#undef _VALIDUS_CX_R3
+
+    state.f0 += a;
+    state.f1 += b;
+    state.f2 += c;
+    state.f3 += d;
+    state.f4 += e;
+    state.f5 += f;
+}
+
+} // namespace detail
+
+/**
+ * @brief Fingerprints a string (or any sequence of octets) at compile time.
+ *
+ * Equivalent to ::validus_hash_mem over the characters of `str` (and so to
+ * ::validus_hash_string, for strings shorter than VALIDUS_MAX_STRING), but
+ * usable in constant expressions: `switch (id) { case
+ * validus::fingerprint("abc").key(): ... }`.
+ *
+ * @param   str The input.
+ * @returns fp  The fingerprint of `str`.
+ */
+constexpr fp fingerprint(std::string_view str) noexcept
+{
+    fp state{VALIDUS_INIT_0, VALIDUS_INIT_1, VALIDUS_INIT_2,
+             VALIDUS_INIT_3, VALIDUS_INIT_4, VALIDUS_INIT_5};
+
+    const std::size_t len = str.size();
+
+    /* as validus_append: whole blocks, then a zero-padded tail. octets are
+     * read little-endian, whatever the host's byte order. */
+    for (std::size_t off = 0; off < len; off += VALIDUS_FP_SIZE_B) {
+        detail::block blk{};
+        for (std::size_t n = 0; n < VALIDUS_FP_SIZE_B && off + n < len; n++) {
+            blk[n / 4] |= static_cast<validus_word>(static_cast<unsigned char>(str[off + n]))
+                << (8 * (n % 4));
+        }
+        detail::compress(state, blk);
+    }
+
+    /* the counter, with the same arithmetic as a single validus_append. */
+    const std::uint64_t octets = len;
+    const validus_word lo      = static_cast<validus_word>(octets << 3);
+    const validus_word hi      = static_cast<validus_word>(octets >> 29) +
+        (static_cast<std::uint64_t>(lo) < (octets << 3) ? 1U : 0U);
+
+    /* as validus_finalize: 0xAA, zeroes, and the counter in the last two words. */
+    detail::block fin{};
+    fin[0]                     = 0xAAU;
+    fin[VALIDUS_FP_SIZE_O - 2] = hi;
+    fin[VALIDUS_FP_SIZE_O - 1] = lo;
+    detail::compress(state, fin);
+
+    return state;
+}
+
+} // namespace validus
+
+#endif /* !_VALIDUS_HPP_INCLUDED */
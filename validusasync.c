@@ -0,0 +1,483 @@
+/**
+ * @file validusasync.c
+ * @brief Implementation of the pipelined (asynchronous) file reader.
+ *
+ * Keeps several reads in flight while the hasher consumes completed buffers,
+ * so that I/O and hashing overlap. Uses io_uring where the kernel supports it,
+ * and a reader thread feeding a bounded ring of buffers otherwise.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusio.h"
+#include "validuspool.h"
+#include "validusstats.h"
+
+#if defined(VALIDUS_HAVE_IO_URING)
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <sys/uio.h>
+# include <unistd.h>
+#endif
+
+/** A buffer in the pipeline. */
+typedef struct {
+    validus_octet* buf; /**< VALIDUS_ASYNC_BLOCKSIZE octets. */
+    uint64_t off;       /**< File offset of the first octet (io_uring only). */
+    size_t len;         /**< Octets requested. */
+    size_t got;         /**< Octets read so far. */
+    bool done;          /**< Whether the read has completed. */
+#if defined(VALIDUS_HAVE_IO_URING)
+    struct iovec iov;   /**< The vector of the read in flight. */
+#endif
+} validus_async_slot;
+
+static bool _validus_async_alloc(validus_async_slot* slots)
+{
+    for (size_t n = 0; n < VALIDUS_ASYNC_DEPTH; n++) {
+        slots[n].buf = _validus_alloc_aligned(VALIDUS_ASYNC_BLOCKSIZE);
+        if (!slots[n].buf) {
+            fprintf(stderr, "failed to allocate %lu octets of heap memory: %d\n",
+                VALIDUS_ASYNC_BLOCKSIZE, errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void _validus_async_free(validus_async_slot* slots)
+{
+    for (size_t n = 0; n < VALIDUS_ASYNC_DEPTH; n++) {
+        _validus_free_aligned(slots[n].buf);
+        slots[n].buf = NULL;
+    }
+}
+
+//////////////////////////////// io_uring //////////////////////////////////////
+
+#if defined(VALIDUS_HAVE_IO_URING)
+
+/** A minimal io_uring instance: one submission and one completion ring. */
+typedef struct {
+    int fd;
+    void* sq_ring;
+    size_t sq_ring_len;
+    void* cq_ring;
+    size_t cq_ring_len;
+    struct io_uring_sqe* sqes;
+    size_t sqes_len;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    unsigned pending;  /**< SQEs queued but not yet submitted. */
+    unsigned inflight; /**< Reads queued but not yet completed. */
+} validus_uring;
+
+static void _validus_uring_close(validus_uring* ring)
+{
+    if (ring->sqes)
+        (void)munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+        (void)munmap(ring->cq_ring, ring->cq_ring_len);
+    if (ring->sq_ring)
+        (void)munmap(ring->sq_ring, ring->sq_ring_len);
+    if (ring->fd >= 0)
+        (void)close(ring->fd);
+}
+
+static bool _validus_uring_open(validus_uring* ring, unsigned entries)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    long fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+        return false;
+
+    ring->fd          = (int)fd;
+    ring->sq_ring_len = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+    ring->cq_ring_len = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_len > ring->sq_ring_len)
+            ring->sq_ring_len = ring->cq_ring_len;
+        ring->cq_ring_len = ring->sq_ring_len;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == ring->sq_ring) {
+        ring->sq_ring = NULL;
+        _validus_uring_close(ring);
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_len, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (MAP_FAILED == ring->cq_ring) {
+            ring->cq_ring = NULL;
+            _validus_uring_close(ring);
+            return false;
+        }
+    }
+
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes     = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (MAP_FAILED == ring->sqes) {
+        ring->sqes = NULL;
+        _validus_uring_close(ring);
+        return false;
+    }
+
+    validus_octet* sq = (validus_octet*)ring->sq_ring;
+    validus_octet* cq = (validus_octet*)ring->cq_ring;
+
+    ring->sq_tail  = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask  = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head  = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail  = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask  = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes     = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+/** Queues a read of the unread remainder of `slot` (tagged with `idx`). */
+static void _validus_uring_queue(validus_uring* ring, validus_fd fd,
+    validus_async_slot* slot, size_t idx)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned pos  = tail & *ring->sq_mask;
+
+    /* the last read of the file is rounded up to the alignment that direct
+     * I/O requires; it returns short, at end of file, either way. */
+    size_t len = (slot->len + VALIDUS_IO_ALIGN - 1) & ~((size_t)VALIDUS_IO_ALIGN - 1);
+
+    slot->iov.iov_base = slot->buf + slot->got;
+    slot->iov.iov_len  = len - slot->got;
+
+    /* READV rather than READ, which requires Linux 5.6. */
+    struct io_uring_sqe* sqe = &ring->sqes[pos];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_READV;
+    sqe->fd        = fd;
+    sqe->off       = slot->off + slot->got;
+    sqe->addr      = (uint64_t)(uintptr_t)&slot->iov;
+    sqe->len       = 1;
+    sqe->user_data = idx;
+
+    ring->sq_array[pos] = pos;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->pending++;
+    ring->inflight++;
+}
+
+/** Submits queued reads, and waits for at least one completion. */
+static bool _validus_uring_enter(validus_uring* ring)
+{
+    for (;;) {
+        long ret = syscall(__NR_io_uring_enter, ring->fd, ring->pending, 1U,
+            IORING_ENTER_GETEVENTS, NULL, 0);
+        if (ret >= 0) {
+            ring->pending -= (unsigned)ret < ring->pending ? (unsigned)ret : ring->pending;
+            return true;
+        }
+        if (EINTR != errno) {
+            fprintf(stderr, "io_uring_enter() failed: %d\n", errno);
+            return false;
+        }
+    }
+}
+
+/**
+ * Processes every available completion: slots whose reads are complete are
+ * marked done, and short reads are resumed if `resume` is true. Returns false
+ * if any read failed.
+ */
+static bool _validus_uring_reap(validus_uring* ring, validus_fd fd,
+    validus_async_slot* slots, bool resume)
+{
+    bool retval   = true;
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        validus_async_slot* slot       = &slots[cqe->user_data];
+
+        ring->inflight--;
+
+        if (cqe->res < 0 && -EINTR != cqe->res && -EAGAIN != cqe->res) {
+            fprintf(stderr, "io_uring read failed: %d\n", -cqe->res);
+            slot->done = true;
+            retval     = false;
+        } else if (cqe->res == 0) {
+            slot->done = true; /* the file shrank. */
+        } else {
+            if (cqe->res > 0)
+                slot->got += (size_t)cqe->res;
+            if (slot->got > slot->len)
+                slot->got = slot->len; /* the file grew. */
+            if (slot->got < slot->len && resume)
+                _validus_uring_queue(ring, fd, slot, (size_t)cqe->user_data);
+            else
+                slot->done = true;
+        }
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return retval;
+}
+
+/**
+ * Hashes a regular file from `pos` (its file pointer) to `size`, with up to
+ * VALIDUS_ASYNC_DEPTH reads in flight, and leaves the file pointer where it
+ * stopped. Returns false if io_uring is unavailable, before any input is
+ * consumed.
+ */
+static bool _validus_hash_uring(validus_stream* stream, validus_fd fd,
+    uint64_t pos, uint64_t size, bool* failed)
+{
+    validus_uring ring;
+    if (!_validus_uring_open(&ring, VALIDUS_ASYNC_DEPTH))
+        return false;
+
+    validus_async_slot slots[VALIDUS_ASYNC_DEPTH];
+    memset(slots, 0, sizeof(slots));
+
+    if (!_validus_async_alloc(slots)) {
+        _validus_async_free(slots);
+        _validus_uring_close(&ring);
+        *failed = true;
+        return true;
+    }
+
+    uint64_t next = pos; /* offset of the next read to queue. */
+    uint64_t hash = pos; /* offset of the next octet to hash. */
+
+    for (size_t n = 0; n < VALIDUS_ASYNC_DEPTH && next < size; n++) {
+        slots[n].off = next;
+        slots[n].len = (size_t)((size - next) < VALIDUS_ASYNC_BLOCKSIZE
+            ? (size - next) : VALIDUS_ASYNC_BLOCKSIZE);
+        _validus_uring_queue(&ring, fd, &slots[n], n);
+        next += slots[n].len;
+    }
+
+    while (hash < size && !*failed) {
+        validus_async_slot* slot =
+            &slots[((hash - pos) / VALIDUS_ASYNC_BLOCKSIZE) % VALIDUS_ASYNC_DEPTH];
+
+        while (!slot->done && !*failed) {
+            if (!_validus_uring_enter(&ring) || !_validus_uring_reap(&ring, fd, slots, true))
+                *failed = true;
+        }
+
+        if (*failed)
+            break;
+
+        VALIDUS_STAT_TIMED(VALIDUS_STAT_COMPUTE_NS,
+            validus_stream_write(stream, slot->buf, slot->got));
+        hash += slot->got;
+
+        if (slot->got < slot->len)
+            break;
+
+        if (next < size) {
+            slot->off  = next;
+            slot->len  = (size_t)((size - next) < VALIDUS_ASYNC_BLOCKSIZE
+                ? (size - next) : VALIDUS_ASYNC_BLOCKSIZE);
+            slot->got  = 0;
+            slot->done = false;
+            _validus_uring_queue(&ring, fd, slot, (size_t)(slot - slots));
+            next += slot->len;
+        }
+    }
+
+    /* the buffers must outlive any reads still in flight; should the ring
+     * fail such that they cannot be reaped, leak them rather than risk it. */
+    bool drained = true;
+    while (ring.inflight > 0) {
+        if (!_validus_uring_enter(&ring)) {
+            drained = false;
+            break;
+        }
+        (void)_validus_uring_reap(&ring, fd, slots, false);
+    }
+
+    _validus_uring_close(&ring);
+    if (drained)
+        _validus_async_free(slots);
+
+    (void)_validus_file_seek(fd, hash);
+    return true;
+}
+
+#endif /* VALIDUS_HAVE_IO_URING */
+
+////////////////////////////// reader thread ///////////////////////////////////
+
+typedef struct {
+    validus_fd fd;
+    validus_async_slot slots[VALIDUS_ASYNC_DEPTH];
+    validus_mutex lock;
+    validus_cond cond;
+    size_t filled;  /**< Slots filled by the reader, in total. */
+    size_t drained; /**< Slots consumed by the hasher, in total. */
+    bool eof;       /**< The reader has reached end of file. */
+    bool error;     /**< The reader failed. */
+    bool stop;      /**< The hasher has stopped consuming. */
+} validus_async_ring;
+
+static void _validus_async_reader(void* arg)
+{
+    validus_async_ring* ring = (validus_async_ring*)arg;
+
+    for (size_t n = 0;; n++) {
+        _validus_mutex_lock(&ring->lock);
+        while (!ring->stop && ring->filled - ring->drained == VALIDUS_ASYNC_DEPTH)
+            _validus_cond_wait(&ring->cond, &ring->lock);
+        bool stop = ring->stop;
+        _validus_mutex_unlock(&ring->lock);
+
+        if (stop)
+            return;
+
+        /* fill the slot completely (pipes return short reads), unless EOF. */
+        validus_async_slot* slot = &ring->slots[n % VALIDUS_ASYNC_DEPTH];
+        bool eof   = false;
+        bool error = false;
+
+        slot->got = 0;
+        while (slot->got < VALIDUS_ASYNC_BLOCKSIZE) {
+            size_t got = 0;
+            if (!_validus_file_read(ring->fd, slot->buf + slot->got,
+                VALIDUS_ASYNC_BLOCKSIZE - slot->got, &got)) {
+                error = true;
+                break;
+            }
+            if (0 == got) {
+                eof = true;
+                break;
+            }
+            slot->got += got;
+        }
+
+        _validus_mutex_lock(&ring->lock);
+        ring->filled++;
+        ring->eof   = eof;
+        ring->error = error;
+        _validus_cond_broadcast(&ring->cond);
+        _validus_mutex_unlock(&ring->lock);
+
+        if (eof || error)
+            return;
+    }
+}
+
+static bool _validus_hash_threaded(validus_stream* stream, validus_fd fd, bool* failed)
+{
+    validus_async_ring ring;
+    memset(&ring, 0, sizeof(ring));
+    ring.fd = fd;
+
+    if (!_validus_async_alloc(ring.slots)) {
+        _validus_async_free(ring.slots);
+        *failed = true;
+        return true;
+    }
+
+    _validus_mutex_init(&ring.lock);
+    _validus_cond_init(&ring.cond);
+
+    validus_thread reader;
+    if (!_validus_thread_create(&reader, &_validus_async_reader, &ring)) {
+        _validus_cond_destroy(&ring.cond);
+        _validus_mutex_destroy(&ring.lock);
+        _validus_async_free(ring.slots);
+        return false;
+    }
+
+    for (size_t n = 0;; n++) {
+        _validus_mutex_lock(&ring.lock);
+        while (ring.filled == n)
+            _validus_cond_wait(&ring.cond, &ring.lock);
+        bool last  = ring.filled == n + 1 && (ring.eof || ring.error);
+        bool error = last && ring.error;
+        _validus_mutex_unlock(&ring.lock);
+
+        if (error) {
+            *failed = true;
+            break;
+        }
+
+        validus_async_slot* slot = &ring.slots[n % VALIDUS_ASYNC_DEPTH];
+        VALIDUS_STAT_TIMED(VALIDUS_STAT_COMPUTE_NS,
+            validus_stream_write(stream, slot->buf, slot->got));
+
+        _validus_mutex_lock(&ring.lock);
+        ring.drained++;
+        _validus_cond_broadcast(&ring.cond);
+        _validus_mutex_unlock(&ring.lock);
+
+        if (last)
+            break;
+    }
+
+    _validus_mutex_lock(&ring.lock);
+    ring.stop = true;
+    _validus_cond_broadcast(&ring.cond);
+    _validus_mutex_unlock(&ring.lock);
+
+    _validus_thread_join(reader);
+    _validus_cond_destroy(&ring.cond);
+    _validus_mutex_destroy(&ring.lock);
+    _validus_async_free(ring.slots);
+
+    return true;
+}
+
+bool _validus_hash_async(validus_stream* stream, validus_fd fd, bool* failed)
+{
+#if defined(VALIDUS_HAVE_IO_URING)
+    uint64_t size = 0, pos = 0;
+    bool regular  = false;
+    if (_validus_file_stat(fd, &size, &regular) && regular &&
+        _validus_file_tell(fd, &pos) && pos < size) {
+        if (_validus_hash_uring(stream, fd, pos, size, failed))
+            return true;
+    }
+#endif
+    return _validus_hash_threaded(stream, fd, failed);
+}
@@ -0,0 +1,531 @@
+/**
+ * @file validusbench.c
+ * @brief The Validus benchmark suite.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusutil.h"
+#include "validuskernel.h"
+#include "validusperf.h"
+#include <math.h>
+#include <version.h>
+
+#if defined(VALIDUS_X86)
+# if defined(_MSC_VER)
+#  include <intrin.h>
+# else
+#  include <x86intrin.h>
+# endif
+#endif
+
+/////////////////////////////// constants //////////////////////////////////////
+
+#define VALIDUS_BENCH_NAME "validus_bench"
+
+/** The largest message size, unless overridden with --max. */
+#define VALIDUS_BENCH_MAX_SIZE (1024ULL * 1024ULL * 1024ULL)
+
+/** The size of each write in the streaming variants. */
+#define VALIDUS_BENCH_CHUNK 4096UL
+
+/** Each measured repetition runs for at least this many milliseconds. */
+#define VALIDUS_BENCH_TARGET_MSEC 20.0
+
+#define VALIDUS_BENCH_REPS   5
+#define VALIDUS_BENCH_WARMUP 1
+
+/** The alignment of the aligned variants; unaligned ones are offset by 1. */
+#define VALIDUS_BENCH_ALIGN 64
+
+/*
+ * The instruction cache eviction code (--cold-icache): 4^6 distinct, dependent
+ * statements, some 70 KiB of straight-line code, which is more than the L1
+ * instruction cache (and decoded-op cache) of current CPUs. It only touches
+ * registers, so the data cache stays warm.
+ */
+#define _VALIDUS_EVICT1(n) x = (x ^ (x >> 15)) * 0x2C1B3C6DU + (uint32_t)n##U;
+#define _VALIDUS_EVICT4(n) \
+    _VALIDUS_EVICT1(n##0) _VALIDUS_EVICT1(n##1) _VALIDUS_EVICT1(n##2) _VALIDUS_EVICT1(n##3)
+#define _VALIDUS_EVICT16(n) \
+    _VALIDUS_EVICT4(n##0) _VALIDUS_EVICT4(n##1) _VALIDUS_EVICT4(n##2) _VALIDUS_EVICT4(n##3)
+#define _VALIDUS_EVICT64(n) \
+    _VALIDUS_EVICT16(n##0) _VALIDUS_EVICT16(n##1) _VALIDUS_EVICT16(n##2) _VALIDUS_EVICT16(n##3)
+#define _VALIDUS_EVICT256(n) \
+    _VALIDUS_EVICT64(n##0) _VALIDUS_EVICT64(n##1) _VALIDUS_EVICT64(n##2) _VALIDUS_EVICT64(n##3)
+#define _VALIDUS_EVICT1024(n) \
+    _VALIDUS_EVICT256(n##0) _VALIDUS_EVICT256(n##1) _VALIDUS_EVICT256(n##2) _VALIDUS_EVICT256(n##3)
+#define _VALIDUS_EVICT4096(n) \
+    _VALIDUS_EVICT1024(n##0) _VALIDUS_EVICT1024(n##1) _VALIDUS_EVICT1024(n##2) _VALIDUS_EVICT1024(n##3)
+
+/////////////////////////////// typedefs ///////////////////////////////////////
+
+typedef struct {
+    const char* name;
+    bool stream;   /**< Hash with a validus_stream, VALIDUS_BENCH_CHUNK at a time. */
+    size_t offset; /**< Offset of the message from an aligned address. */
+} validus_bench_variant;
+
+typedef struct {
+    uint64_t size;
+    const validus_bench_variant* variant;
+    uint64_t iters;      /**< Messages hashed per repetition. */
+    double ns_msg;       /**< Mean nanoseconds per message. */
+    double ns_stddev;    /**< Standard deviation of ns_msg across repetitions. */
+    double cycles_byte;  /**< Mean TSC cycles per octet; < 0 if unavailable. */
+    double mib_sec;      /**< Throughput derived from ns_msg. */
+    double per_block[VALIDUS_PERF_NCOUNTERS]; /**< Hardware counts per 192-octet
+                                                   block; < 0 if unavailable. */
+} validus_bench_result;
+
+typedef struct {
+    uint64_t max_size;
+    size_t reps;
+    size_t warmup;
+    const char* json;
+    FILE* table;       /**< Where the table goes: stderr if the JSON goes to stdout. */
+    bool counters;     /**< Whether to read hardware performance counters. */
+    bool cold;         /**< Evict the instruction cache before each message. */
+    validus_perf perf; /**< Valid if `counters` is true. */
+} validus_bench_opts;
+
+static const validus_bench_variant variants[] = {
+    {"oneshot-aligned",   false, 0},
+    {"oneshot-unaligned", false, 1},
+    {"stream-aligned",    true,  0},
+    {"stream-unaligned",  true,  1}
+};
+
+static const uint64_t sizes[] = {
+    0ULL, 1ULL, 16ULL, 64ULL, 191ULL, 192ULL, 193ULL, 256ULL, 1024ULL, 4096ULL,
+    16384ULL, 65536ULL, 262144ULL, 1048576ULL, 16777216ULL, 268435456ULL,
+    1073741824ULL
+};
+
+#define VALIDUS_BENCH_NVARIANTS (sizeof(variants) / sizeof(variants[0]))
+#define VALIDUS_BENCH_NSIZES    (sizeof(sizes) / sizeof(sizes[0]))
+
+/** Keeps the compiler from discarding the fingerprints. */
+static volatile validus_word sink;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint64_t _validus_bench_cycles(void)
+{
+#if defined(VALIDUS_X86)
+    return (uint64_t)__rdtsc();
+#else
+    return 0ULL;
+#endif
+}
+
+#if defined(__GNUC__)
+__attribute__((noinline))
+#elif defined(_MSC_VER)
+__declspec(noinline)
+#endif
+static void _validus_bench_evict(void)
+{
+    uint32_t x = sink;
+    _VALIDUS_EVICT4096(1)
+    sink = x;
+}
+
+static void _validus_bench_hash(const validus_bench_variant* variant,
+    const validus_octet* msg, size_t len)
+{
+    validus_state state;
+
+    /* not validus_hash_mem, which rejects empty messages. */
+    if (!variant->stream) {
+        validus_init(&state);
+        validus_append(&state, msg, len);
+        validus_finalize(&state);
+    } else {
+        validus_stream stream;
+        validus_stream_init(&stream);
+        for (size_t off = 0; off < len; off += VALIDUS_BENCH_CHUNK) {
+            size_t chunk = len - off < VALIDUS_BENCH_CHUNK ? len - off : VALIDUS_BENCH_CHUNK;
+            validus_stream_write(&stream, msg + off, chunk);
+        }
+        validus_stream_finalize(&stream);
+        state = stream.state;
+    }
+
+    sink ^= state.f0;
+}
+
+/**
+ * Times `iters` messages; returns elapsed milliseconds, and TSC cycles. If
+ * `cold`, each message is preceded by the eviction code; if `variant` is NULL,
+ * only the eviction code is run. If `perf` is non-NULL, the hardware counts are
+ * added to its totals.
+ */
+static double _validus_bench_time(const validus_bench_variant* variant,
+    const validus_octet* msg, size_t len, uint64_t iters, bool cold,
+    uint64_t* cycles, validus_perf* perf)
+{
+    validus_timer timer;
+
+    if (perf)
+        validus_perf_start(perf);
+
+    validus_timer_start(&timer);
+    uint64_t start = _validus_bench_cycles();
+
+    if (!cold) {
+        for (uint64_t n = 0; n < iters; n++)
+            _validus_bench_hash(variant, msg, len);
+    } else if (!variant) {
+        for (uint64_t n = 0; n < iters; n++)
+            _validus_bench_evict();
+    } else {
+        for (uint64_t n = 0; n < iters; n++) {
+            _validus_bench_evict();
+            _validus_bench_hash(variant, msg, len);
+        }
+    }
+
+    *cycles     = _validus_bench_cycles() - start;
+    double msec = validus_timer_elapsed(&timer);
+
+    if (perf)
+        validus_perf_stop(perf);
+
+    return msec;
+}
+
+static void _validus_bench_run(validus_bench_opts* opts, const validus_octet* buf,
+    validus_bench_result* result)
+{
+    const validus_octet* msg = buf + result->variant->offset;
+    size_t len               = (size_t)result->size;
+    uint64_t cycles          = 0ULL;
+
+    /* calibrate: double the iterations until a repetition is long enough. */
+    uint64_t iters = 1ULL;
+    while (_validus_bench_time(result->variant, msg, len, iters, opts->cold, &cycles,
+           NULL) < VALIDUS_BENCH_TARGET_MSEC && iters < (1ULL << 40))
+        iters *= 2ULL;
+
+    for (size_t n = 0; n < opts->warmup; n++)
+        (void)_validus_bench_time(result->variant, msg, len, iters, opts->cold, &cycles, NULL);
+
+    double sum = 0.0, sum_sq = 0.0, sum_cycles = 0.0;
+    validus_perf* perf = opts->counters ? &opts->perf : NULL;
+
+    /* with a cold instruction cache, the cost of the eviction code alone is
+     * measured ahead of every repetition, and subtracted from it. */
+    uint64_t base_counts[VALIDUS_PERF_NCOUNTERS] = {0};
+
+    validus_perf_reset(perf);
+
+    for (size_t n = 0; n < opts->reps; n++) {
+        double base_ns = 0.0, base_cycles = 0.0;
+
+        if (opts->cold) {
+            uint64_t before[VALIDUS_PERF_NCOUNTERS];
+            memcpy(before, opts->perf.values, sizeof(before));
+
+            double msec = _validus_bench_time(NULL, msg, len, iters, true, &cycles, perf);
+            base_ns     = msec * 1e6 / (double)iters;
+            base_cycles = (double)cycles / (double)iters;
+
+            for (size_t c = 0; perf && c < VALIDUS_PERF_NCOUNTERS; c++)
+                base_counts[c] += opts->perf.values[c] - before[c];
+        }
+
+        double msec = _validus_bench_time(result->variant, msg, len, iters, opts->cold,
+            &cycles, perf);
+        double ns   = msec * 1e6 / (double)iters - base_ns;
+        sum        += ns;
+        sum_sq     += ns * ns;
+        sum_cycles += (double)cycles / (double)iters - base_cycles;
+    }
+
+    double reps = (double)opts->reps;
+    double mean = sum / reps;
+    double var  = opts->reps > 1 ? (sum_sq - reps * mean * mean) / (reps - 1.0) : 0.0;
+
+    result->iters       = iters;
+    result->ns_msg      = mean;
+    result->ns_stddev   = var > 0.0 ? sqrt(var) : 0.0;
+    result->cycles_byte = -1.0;
+    result->mib_sec     = 0.0;
+
+    if (len > 0) {
+#if defined(VALIDUS_X86)
+        result->cycles_byte = sum_cycles / reps / (double)len;
+#endif
+        result->mib_sec = ((double)len / 1024.0 / 1024.0) / (mean / 1e9);
+    }
+
+    /* every message compresses its data blocks (the last one padded), and then
+     * the finalization block. */
+    double blocks = (double)(len / VALIDUS_FP_SIZE_B + (len % VALIDUS_FP_SIZE_B ? 1 : 0) + 1) *
+        (double)iters * reps;
+
+    for (size_t n = 0; n < VALIDUS_PERF_NCOUNTERS; n++) {
+        result->per_block[n] = validus_perf_has(perf, (validus_perf_counter)n)
+            ? ((double)opts->perf.values[n] - (double)base_counts[n]) / blocks : -1.0;
+    }
+}
+
+static void _validus_bench_print_size(char* out, size_t len, uint64_t size)
+{
+    static const char* const units[] = {"B", "KiB", "MiB", "GiB"};
+    size_t unit = 0;
+
+    while (unit < 3 && size >= 1024 && 0 == size % 1024) {
+        size /= 1024;
+        unit++;
+    }
+
+    (void)snprintf(out, len, "%" PRIu64 " %s", size, units[unit]);
+}
+
+static void _validus_bench_print_row(const validus_bench_result* result, FILE* out,
+    bool counters)
+{
+    char size[32]   = {0};
+    char cycles[32] = "-";
+
+    _validus_bench_print_size(size, sizeof(size), result->size);
+
+    if (result->cycles_byte >= 0.0)
+        (void)snprintf(cycles, sizeof(cycles), "%.2f", result->cycles_byte);
+
+    fprintf(out, "%10s  %-18s %12" PRIu64 " %16.1f %8.2f%% %10s %12.1f", size,
+        result->variant->name, result->iters, result->ns_msg,
+        result->ns_msg > 0.0 ? result->ns_stddev / result->ns_msg * 100.0 : 0.0,
+        cycles, result->mib_sec);
+
+    if (counters) {
+        const double* pb = result->per_block;
+        char ipc[32]     = "-";
+
+        if (pb[VALIDUS_PERF_CYCLES] > 0.0 && pb[VALIDUS_PERF_INSTRUCTIONS] >= 0.0)
+            (void)snprintf(ipc, sizeof(ipc), "%.2f",
+                pb[VALIDUS_PERF_INSTRUCTIONS] / pb[VALIDUS_PERF_CYCLES]);
+
+        fprintf(out, " %10.1f %10.1f %6s %10.3f %10.3f", pb[VALIDUS_PERF_CYCLES],
+            pb[VALIDUS_PERF_INSTRUCTIONS], ipc, pb[VALIDUS_PERF_L1I_MISSES],
+            pb[VALIDUS_PERF_BRANCH_MISSES]);
+    }
+
+    fprintf(out, "\n");
+    fflush(out);
+}
+
+static bool _validus_bench_write_json(const validus_bench_opts* opts,
+    const validus_bench_result* results, size_t count)
+{
+    FILE* fp = 0 == strcmp(opts->json, "-") ? stdout : fopen(opts->json, "w");
+    if (!fp) {
+        fprintf(stderr, "failed to open file '%s': %d\n", opts->json, errno);
+        return false;
+    }
+
+    fprintf(fp, "{\n  \"version\": \"%" PRIu16 ".%" PRIu16 ".%" PRIu16 "%s\",\n"
+        "  \"commit\": \"%s\",\n  \"kernel\": \"%s\",\n  \"reps\": %zu,\n"
+        "  \"warmup\": %zu,\n  \"counters\": %s,\n  \"cold_icache\": %s,\n"
+        "  \"results\": [\n", VERSION_MAJ, VERSION_MIN, VERSION_BLD, VERSION_TYPE,
+        GIT_COMMIT_HASH, validus_kernel_name(), opts->reps, opts->warmup,
+        opts->counters ? "true" : "false", opts->cold ? "true" : "false");
+
+    for (size_t n = 0; n < count; n++) {
+        const validus_bench_result* result = &results[n];
+        char cycles[32]                    = "null";
+        char hw[VALIDUS_PERF_NCOUNTERS][32];
+
+        if (result->cycles_byte >= 0.0)
+            (void)snprintf(cycles, sizeof(cycles), "%.4f", result->cycles_byte);
+
+        for (size_t c = 0; c < VALIDUS_PERF_NCOUNTERS; c++) {
+            if (result->per_block[c] >= 0.0)
+                (void)snprintf(hw[c], sizeof(hw[c]), "%.4f", result->per_block[c]);
+            else
+                (void)snprintf(hw[c], sizeof(hw[c]), "null");
+        }
+
+        fprintf(fp, "    {\"size\": %" PRIu64 ", \"variant\": \"%s\", \"iterations\": %"
+            PRIu64 ", \"ns_per_msg\": %.3f, \"ns_stddev\": %.3f, \"cycles_per_byte\": %s, "
+            "\"mib_per_sec\": %.3f, \"per_block\": {\"cycles\": %s, \"instructions\": %s, "
+            "\"l1i_misses\": %s, \"branch_misses\": %s}}%s\n", result->size,
+            result->variant->name, result->iters, result->ns_msg, result->ns_stddev, cycles,
+            result->mib_sec, hw[VALIDUS_PERF_CYCLES], hw[VALIDUS_PERF_INSTRUCTIONS],
+            hw[VALIDUS_PERF_L1I_MISSES], hw[VALIDUS_PERF_BRANCH_MISSES],
+            n + 1 < count ? "," : "");
+    }
+
+    fprintf(fp, "  ]\n}\n");
+
+    if (fp != stdout)
+        return 0 == fclose(fp);
+
+    fflush(fp);
+    return true;
+}
+
+static bool _validus_bench_parse_size(const char* str, uint64_t* size)
+{
+    char* end      = NULL;
+    uint64_t value = strtoull(str, &end, 10);
+
+    switch (end ? *end : '\0') {
+        case 'G': case 'g': value *= 1024ULL; /* fall through */
+        case 'M': case 'm': value *= 1024ULL; /* fall through */
+        case 'K': case 'k': value *= 1024ULL; end++; break;
+        case '\0': break;
+        default: return false;
+    }
+
+    if (end == str || '\0' != *end)
+        return false;
+
+    *size = value;
+    return true;
+}
+
+static int _validus_bench_usage(void)
+{
+    fprintf(stderr, VALIDUS_BENCH_NAME " usage:\n");
+    fprintf(stderr, "\t--max SIZE    Largest message size (K, M and G suffixes; default 1G)\n");
+    fprintf(stderr, "\t--reps N      Measured repetitions per case (default %d)\n", VALIDUS_BENCH_REPS);
+    fprintf(stderr, "\t--warmup N    Warmup repetitions per case (default %d)\n", VALIDUS_BENCH_WARMUP);
+    fprintf(stderr, "\t--json PATH   Also write the results as JSON to PATH ('-' for stdout,\n"
+        "\t              moving the table to stderr)\n");
+    fprintf(stderr, "\t--no-counters Do not read hardware performance counters\n");
+    fprintf(stderr, "\t--cold-icache Evict the instruction cache before each message\n");
+    fprintf(stderr, "\t-h            Show this message\n");
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[])
+{
+    validus_bench_opts opts = {
+        VALIDUS_BENCH_MAX_SIZE, VALIDUS_BENCH_REPS, VALIDUS_BENCH_WARMUP, NULL, NULL, true, false,
+        {{0}, {0}, false}
+    };
+
+    for (int n = 1; n < argc; n++) {
+        const char* value = n + 1 < argc ? argv[n + 1] : NULL;
+
+        if (0 == strcmp(argv[n], "--no-counters")) {
+            opts.counters = false;
+            continue;
+        } else if (0 == strcmp(argv[n], "--cold-icache")) {
+            opts.cold = true;
+            continue;
+        } else if (0 == strcmp(argv[n], "--max") && value) {
+            if (!_validus_bench_parse_size(value, &opts.max_size))
+                return _validus_bench_usage();
+        } else if (0 == strcmp(argv[n], "--reps") && value) {
+            opts.reps = (size_t)strtoul(value, NULL, 10);
+            if (0 == opts.reps)
+                return _validus_bench_usage();
+        } else if (0 == strcmp(argv[n], "--warmup") && value) {
+            opts.warmup = (size_t)strtoul(value, NULL, 10);
+        } else if (0 == strcmp(argv[n], "--json") && value) {
+            opts.json = value;
+        } else {
+            return _validus_bench_usage();
+        }
+        n++;
+    }
+
+    if (opts.max_size > SIZE_MAX - 2 * VALIDUS_BENCH_ALIGN) {
+        fprintf(stderr, "--max is too large for this platform\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t largest = 0;
+    for (size_t n = 0; n < VALIDUS_BENCH_NSIZES && sizes[n] <= opts.max_size; n++)
+        largest = (size_t)sizes[n];
+
+    validus_octet* mem = malloc(largest + 2 * VALIDUS_BENCH_ALIGN);
+    if (!mem) {
+        fprintf(stderr, "failed to allocate %zu octets of heap memory: %d\n",
+            largest + 2 * VALIDUS_BENCH_ALIGN, errno);
+        return EXIT_FAILURE;
+    }
+
+    validus_octet* buf = mem + (VALIDUS_BENCH_ALIGN -
+        ((uintptr_t)mem % VALIDUS_BENCH_ALIGN)) % VALIDUS_BENCH_ALIGN;
+
+    /* a fixed pseudo-random pattern (xorshift32). */
+    uint32_t x = 0x9e3779b9U;
+    for (size_t n = 0; n < largest + VALIDUS_BENCH_ALIGN; n++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[n] = (validus_octet)x;
+    }
+
+    validus_bench_result* results = calloc(VALIDUS_BENCH_NSIZES * VALIDUS_BENCH_NVARIANTS,
+        sizeof(validus_bench_result));
+    if (!results) {
+        fprintf(stderr, "failed to allocate memory for results: %d\n", errno);
+        free(mem);
+        return EXIT_FAILURE;
+    }
+
+    if (opts.counters && !validus_perf_open(&opts.perf)) {
+        fprintf(stderr, "hardware performance counters are unavailable; timing only\n");
+        opts.counters = false;
+    }
+
+    /* JSON written to stdout stays parseable: the table goes to stderr. */
+    opts.table = opts.json && 0 == strcmp(opts.json, "-") ? stderr : stdout;
+
+    fprintf(opts.table, VALIDUS_BENCH_NAME " %" PRIu16 ".%" PRIu16 ".%" PRIu16 "%s (%s) [%s]: "
+        "%zu reps, %zu warmup%s\n\n", VERSION_MAJ, VERSION_MIN, VERSION_BLD,
+        VERSION_TYPE, GIT_COMMIT_HASH, validus_kernel_name(), opts.reps, opts.warmup,
+        opts.cold ? ", cold instruction cache" : "");
+    fprintf(opts.table, "%10s  %-18s %12s %16s %9s %10s %12s", "size", "variant", "iters",
+        "ns/msg", "stddev", "cycles/B", "MiB/s");
+    if (opts.counters)
+        fprintf(opts.table, " %10s %10s %6s %10s %10s", "cyc/blk", "ins/blk", "IPC",
+            "L1i-m/blk", "br-m/blk");
+    fprintf(opts.table, "\n");
+
+    size_t count = 0;
+    for (size_t s = 0; s < VALIDUS_BENCH_NSIZES && sizes[s] <= opts.max_size; s++) {
+        for (size_t v = 0; v < VALIDUS_BENCH_NVARIANTS; v++) {
+            validus_bench_result* result = &results[count++];
+            result->size                 = sizes[s];
+            result->variant              = &variants[v];
+            _validus_bench_run(&opts, buf, result);
+            _validus_bench_print_row(result, opts.table, opts.counters);
+        }
+    }
+
+    bool ok = !opts.json || _validus_bench_write_json(&opts, results, count);
+
+    if (opts.counters)
+        validus_perf_close(&opts.perf);
+
+    free(results);
+    free(mem);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
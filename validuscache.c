@@ -0,0 +1,405 @@
+/**
+ * @file validuscache.c
+ * @brief Implementation of the persistent fingerprint cache.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusio.h"
+
+#if !defined(__WIN__)
+# include <fcntl.h>
+# include <unistd.h>
+# include <stdatomic.h>
+# include <sys/file.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+/** "VLDC", little-endian. */
+#define VALIDUS_CACHE_MAGIC   0x43444c56U
+#define VALIDUS_CACHE_VERSION 2U
+
+/** The size, in octets, of the header; the slots follow it. */
+#define VALIDUS_CACHE_HEADER  4096
+
+/** The words of a slot. */
+enum {
+    VALIDUS_CACHE_DEV = 0,
+    VALIDUS_CACHE_INO,
+    VALIDUS_CACHE_SIZE,
+    VALIDUS_CACHE_MTIME,
+    VALIDUS_CACHE_CTIME,
+    VALIDUS_CACHE_BITS, /**< validus_state::bits, low word first. */
+    VALIDUS_CACHE_FP01,
+    VALIDUS_CACHE_FP23,
+    VALIDUS_CACHE_FP45,
+    VALIDUS_CACHE_MID_OFFSET, /**< Octets hashed into the midstate; zero if none. */
+    VALIDUS_CACHE_MID01,
+    VALIDUS_CACHE_MID23,
+    VALIDUS_CACHE_MID45,
+    VALIDUS_CACHE_MID_TAIL,   /**< Check of the file's last octets (see
+                                   ::validus_cache_mid). */
+    VALIDUS_CACHE_FLAGS,      /**< VALIDUS_CACHE_MID_ONLY, or zero. */
+    VALIDUS_CACHE_CHECK,      /**< Checksum of the other words; zero if empty. */
+    VALIDUS_CACHE_WORDS
+};
+
+/** The entry was recorded while the file was still changing: its fingerprint
+ * is not to be trusted on metadata alone, but its midstate (which is checked
+ * against the file's contents) may still be resumed. */
+#define VALIDUS_CACHE_MID_ONLY 0x1ULL
+
+#if !defined(__WIN__)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t slots;
+} validus_cache_header;
+
+/**
+ * An entry. Its words are written and read individually, by any number of
+ * threads and processes; the checksum is written last, and an entry is only
+ * believed if its checksum matches the words read alongside it.
+ */
+typedef struct {
+    _Atomic uint64_t w[VALIDUS_CACHE_WORDS];
+} validus_cache_slot;
+
+struct validus_cache {
+    int fd;
+    void* map;
+    size_t len;
+    validus_cache_slot* slots;
+    uint64_t mask;
+};
+
+/** The splitmix64 finalizer. */
+static inline uint64_t _validus_cache_mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t _validus_cache_check(const uint64_t* w)
+{
+    uint64_t h = 0x9e3779b97f4a7c15ULL;
+    for (size_t n = 0; n < VALIDUS_CACHE_CHECK; n++)
+        h = _validus_cache_mix(h ^ w[n]) + 0x9e3779b97f4a7c15ULL;
+    return h ? h : 1ULL;
+}
+
+static inline uint64_t _validus_cache_home(const validus_cache* cache, const validus_file_id* id)
+{
+    return _validus_cache_mix(id->dev * 0x9e3779b97f4a7c15ULL ^ id->ino) & cache->mask;
+}
+
+/** Reads a slot; returns false if it is empty, and sets `intact` to whether it
+ * is an entry (rather than a torn one). */
+static bool _validus_cache_load(const validus_cache_slot* slot, uint64_t* w, bool* intact)
+{
+    for (size_t n = 0; n < VALIDUS_CACHE_WORDS; n++)
+        w[n] = atomic_load_explicit(&slot->w[n], memory_order_relaxed);
+
+    atomic_thread_fence(memory_order_acquire);
+
+    *intact = w[VALIDUS_CACHE_CHECK] == _validus_cache_check(w);
+    return 0ULL != w[VALIDUS_CACHE_CHECK];
+}
+
+/** Reads (and, if necessary, initializes) the header; called under flock. */
+static bool _validus_cache_prepare(int fd, size_t* slots, bool grow)
+{
+    validus_cache_header hdr = {0};
+    struct stat st;
+
+    if (0 != fstat(fd, &st))
+        return false;
+
+    ssize_t got = pread(fd, &hdr, sizeof(hdr), 0);
+    if (got == (ssize_t)sizeof(hdr) && VALIDUS_CACHE_MAGIC == hdr.magic &&
+        VALIDUS_CACHE_VERSION == hdr.version && hdr.slots > 0 &&
+        0 == (hdr.slots & (hdr.slots - 1)) && hdr.slots <= (1ULL << 32) &&
+        (uint64_t)st.st_size == VALIDUS_CACHE_HEADER + hdr.slots * sizeof(validus_cache_slot)) {
+        if (!grow || hdr.slots >= (uint64_t)*slots) {
+            *slots = (size_t)hdr.slots;
+            return true;
+        }
+
+        /* too small for what was asked: extend it in place. Every entry checks
+         * its own key, so those left where the old mask put them are still
+         * found by probing (or simply missed), and processes still using the
+         * old size keep working. */
+        off_t len = (off_t)(VALIDUS_CACHE_HEADER + (uint64_t)*slots * sizeof(validus_cache_slot));
+        if (0 != ftruncate(fd, len))
+            return false;
+
+        hdr.slots = (uint64_t)*slots;
+        return pwrite(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr);
+    }
+
+    /* new, or damaged (by a crash during initialization): start afresh. The
+     * header goes last, so it is only valid once the slots exist. */
+    off_t len = (off_t)(VALIDUS_CACHE_HEADER + (uint64_t)*slots * sizeof(validus_cache_slot));
+    if (0 != ftruncate(fd, 0) || 0 != ftruncate(fd, len))
+        return false;
+
+    hdr.magic   = VALIDUS_CACHE_MAGIC;
+    hdr.version = VALIDUS_CACHE_VERSION;
+    hdr.slots   = (uint64_t)*slots;
+
+    return pwrite(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr);
+}
+
+#endif /* !__WIN__ */
+
+validus_cache* validus_cache_open(const char* path, size_t slots)
+{
+    if (!path || !*path)
+        return NULL;
+
+#if defined(__WIN__)
+    (void)slots;
+    fprintf(stderr, "the fingerprint cache is not supported on this platform\n");
+    return NULL;
+#else
+    bool grow = 0 != slots;
+    if (0 == slots)
+        slots = VALIDUS_CACHE_SLOTS;
+    if (slots > (1ULL << 32))
+        slots = (size_t)(1ULL << 32);
+
+    size_t pow2 = 1;
+    while (pow2 < slots)
+        pow2 <<= 1;
+    slots = pow2;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "failed to open cache '%s': %d\n", path, errno);
+        return NULL;
+    }
+
+    /* one process initializes a new cache; the others wait for it. */
+    int ret;
+    do {
+        ret = flock(fd, LOCK_EX);
+    } while (0 != ret && EINTR == errno);
+
+    bool ok = 0 == ret && _validus_cache_prepare(fd, &slots, grow);
+    int err = errno;
+    (void)flock(fd, LOCK_UN);
+
+    if (!ok) {
+        fprintf(stderr, "failed to initialize cache '%s': %d\n", path, err);
+        (void)close(fd);
+        return NULL;
+    }
+
+    validus_cache* cache = calloc(1, sizeof(validus_cache));
+    if (!cache) {
+        fprintf(stderr, "failed to allocate memory: %d\n", errno);
+        (void)close(fd);
+        return NULL;
+    }
+
+    cache->fd   = fd;
+    cache->len  = VALIDUS_CACHE_HEADER + slots * sizeof(validus_cache_slot);
+    cache->mask = (uint64_t)slots - 1;
+    cache->map  = mmap(NULL, cache->len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (MAP_FAILED == cache->map) {
+        fprintf(stderr, "failed to map cache '%s': %d\n", path, errno);
+        (void)close(fd);
+        free(cache);
+        return NULL;
+    }
+
+    cache->slots = (validus_cache_slot*)((validus_octet*)cache->map + VALIDUS_CACHE_HEADER);
+    return cache;
+#endif
+}
+
+void validus_cache_close(validus_cache* cache)
+{
+    if (!cache)
+        return;
+
+#if !defined(__WIN__)
+    (void)munmap(cache->map, cache->len);
+    (void)close(cache->fd);
+#endif
+    free(cache);
+}
+
+#if !defined(__WIN__)
+/** Finds the intact entry for the file `id` (whatever its version), and reads
+ * it into `w`. */
+static bool _validus_cache_find(validus_cache* cache, const validus_file_id* id, uint64_t* w)
+{
+    uint64_t home = _validus_cache_home(cache, id);
+
+    for (uint64_t n = 0; n < VALIDUS_CACHE_PROBES; n++) {
+        bool intact = false;
+
+        if (!_validus_cache_load(&cache->slots[(home + n) & cache->mask], w, &intact))
+            return false; /* the end of the chain. */
+
+        if (intact && w[VALIDUS_CACHE_DEV] == id->dev && w[VALIDUS_CACHE_INO] == id->ino)
+            return true;
+    }
+
+    return false;
+}
+
+static void _validus_cache_unpack(const uint64_t* w, size_t first, validus_state* state)
+{
+    state->f0 = (validus_word)(w[first] >> 32);
+    state->f1 = (validus_word)w[first];
+    state->f2 = (validus_word)(w[first + 1] >> 32);
+    state->f3 = (validus_word)w[first + 1];
+    state->f4 = (validus_word)(w[first + 2] >> 32);
+    state->f5 = (validus_word)w[first + 2];
+}
+#endif
+
+bool _validus_cache_get(validus_cache* cache, const validus_file_id* id, validus_state* state)
+{
+#if defined(__WIN__)
+    (void)cache;
+    (void)id;
+    (void)state;
+    return false;
+#else
+    uint64_t w[VALIDUS_CACHE_WORDS];
+
+    if (!_validus_cache_find(cache, id, w) ||
+        0ULL != (w[VALIDUS_CACHE_FLAGS] & VALIDUS_CACHE_MID_ONLY) ||
+        w[VALIDUS_CACHE_SIZE] != id->size ||
+        w[VALIDUS_CACHE_MTIME] != (uint64_t)id->mtime_ns ||
+        w[VALIDUS_CACHE_CTIME] != (uint64_t)id->ctime_ns)
+        return false;
+
+    state->bits[0] = (validus_word)w[VALIDUS_CACHE_BITS];
+    state->bits[1] = (validus_word)(w[VALIDUS_CACHE_BITS] >> 32);
+    _validus_cache_unpack(w, VALIDUS_CACHE_FP01, state);
+
+    return true;
+#endif
+}
+
+bool _validus_cache_get_mid(validus_cache* cache, const validus_file_id* id,
+    validus_cache_mid* mid)
+{
+#if defined(__WIN__)
+    (void)cache;
+    (void)id;
+    (void)mid;
+    return false;
+#else
+    uint64_t w[VALIDUS_CACHE_WORDS];
+
+    if (!_validus_cache_find(cache, id, w) || 0ULL == w[VALIDUS_CACHE_MID_OFFSET] ||
+        w[VALIDUS_CACHE_SIZE] >= id->size)
+        return false;
+
+    memset(mid, 0, sizeof(validus_cache_mid));
+    mid->size   = w[VALIDUS_CACHE_SIZE];
+    mid->offset = w[VALIDUS_CACHE_MID_OFFSET];
+    mid->tail   = w[VALIDUS_CACHE_MID_TAIL];
+    _validus_cache_unpack(w, VALIDUS_CACHE_MID01, &mid->state);
+
+    return true;
+#endif
+}
+
+void _validus_cache_put(validus_cache* cache, const validus_file_id* id,
+    const validus_state* state, const validus_cache_mid* mid)
+{
+#if defined(__WIN__)
+    (void)cache;
+    (void)id;
+    (void)state;
+    (void)mid;
+#else
+    struct timespec now;
+    if (0 != clock_gettime(CLOCK_REALTIME, &now))
+        return;
+
+    int64_t now_ns  = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+    int64_t changed = id->mtime_ns > id->ctime_ns ? id->mtime_ns : id->ctime_ns;
+    bool settled    = now_ns - changed >= VALIDUS_CACHE_SETTLE_NS;
+    bool resumable  = mid && mid->offset > 0;
+    if (!settled && !resumable)
+        return;
+
+    uint64_t e[VALIDUS_CACHE_WORDS] = {0};
+    e[VALIDUS_CACHE_DEV]   = id->dev;
+    e[VALIDUS_CACHE_INO]   = id->ino;
+    e[VALIDUS_CACHE_SIZE]  = id->size;
+    e[VALIDUS_CACHE_MTIME] = (uint64_t)id->mtime_ns;
+    e[VALIDUS_CACHE_CTIME] = (uint64_t)id->ctime_ns;
+    e[VALIDUS_CACHE_BITS]  = (uint64_t)state->bits[1] << 32 | state->bits[0];
+    e[VALIDUS_CACHE_FP01]  = (uint64_t)state->f0 << 32 | state->f1;
+    e[VALIDUS_CACHE_FP23]  = (uint64_t)state->f2 << 32 | state->f3;
+    e[VALIDUS_CACHE_FP45]  = (uint64_t)state->f4 << 32 | state->f5;
+
+    if (resumable) {
+        e[VALIDUS_CACHE_MID_OFFSET] = mid->offset;
+        e[VALIDUS_CACHE_MID01]      = (uint64_t)mid->state.f0 << 32 | mid->state.f1;
+        e[VALIDUS_CACHE_MID23]      = (uint64_t)mid->state.f2 << 32 | mid->state.f3;
+        e[VALIDUS_CACHE_MID45]      = (uint64_t)mid->state.f4 << 32 | mid->state.f5;
+        e[VALIDUS_CACHE_MID_TAIL]   = mid->tail;
+        e[VALIDUS_CACHE_FLAGS]      = settled ? 0ULL : VALIDUS_CACHE_MID_ONLY;
+    }
+
+    e[VALIDUS_CACHE_CHECK] = _validus_cache_check(e);
+
+    /* this file's own slot, or the first free (or torn) one; failing those,
+     * the home slot is replaced. */
+    uint64_t home = _validus_cache_home(cache, id);
+    validus_cache_slot* slot = &cache->slots[home];
+
+    for (uint64_t n = 0; n < VALIDUS_CACHE_PROBES; n++) {
+        validus_cache_slot* probe = &cache->slots[(home + n) & cache->mask];
+        uint64_t w[VALIDUS_CACHE_WORDS];
+        bool intact = false;
+
+        if (!_validus_cache_load(probe, w, &intact) || !intact ||
+            (w[VALIDUS_CACHE_DEV] == id->dev && w[VALIDUS_CACHE_INO] == id->ino)) {
+            slot = probe;
+            break;
+        }
+    }
+
+    for (size_t n = 0; n < VALIDUS_CACHE_CHECK; n++)
+        atomic_store_explicit(&slot->w[n], e[n], memory_order_relaxed);
+
+    atomic_store_explicit(&slot->w[VALIDUS_CACHE_CHECK], e[VALIDUS_CACHE_CHECK],
+        memory_order_release);
+#endif
+}
@@ -26,8 +26,27 @@
  */
 #include "validuscli.h"
 
+/** The fingerprint cache in use, closed upon exit. */
+static validus_cache* _validus_cli_cache = NULL;
+
 int main(int argc, char *argv[])
 {
+    /* Extract modifier options. */
+    validus_cli_opts opts = {0};
+    if (!_validus_cli_parse_opts(&argc, argv, &opts))
+        goto _print_usage;
+
+    if (opts.stats)
+        (void)atexit(&_validus_cli_print_stats);
+
+    /* With no argument, hash stdin, unless it is a terminal. */
+#if defined(__WIN__)
+    if (argc < 2 && !_isatty(_fileno(stdin)))
+#else
+    if (argc < 2 && !isatty(STDIN_FILENO))
+#endif
+        return validus_cli_hash_stdin(&opts);
+
     /* Check argument count. */
     if (argc < 2) {
         _validus_cli_print_error("no argument supplied");
@@ -42,9 +61,47 @@ int main(int argc, char *argv[])
     if (strncmp(argv[1], VALIDUS_CLI_STR, 2) == 0)
         return validus_cli_hash_string(argv[2]);
 
-    /* Hash file */
-    if (strncmp(argv[1], VALIDUS_CLI_FILE, 2) == 0)
-        return validus_cli_hash_file(argv[2]);
+    /* Hash file(s) */
+    if (strncmp(argv[1], VALIDUS_CLI_FILE, 2) == 0) {
+        if (opts.blocks > 0) {
+            if (argc > 3) {
+                _validus_cli_print_error(VALIDUS_CLI_BLOCKS " takes a single file");
+                goto _print_usage;
+            }
+            return validus_cli_hash_ranges(argv[2], &opts);
+        }
+        _validus_cli_open_cache(&opts);
+        if (argc > 3)
+            return validus_cli_hash_files(&argv[2], (size_t)(argc - 2), &opts);
+        return validus_cli_hash_file(argv[2], &opts);
+    }
+
+    /* Hash file (tree mode) */
+    if (strncmp(argv[1], VALIDUS_CLI_TREE, 2) == 0)
+        return validus_cli_hash_file_tree(argv[2], &opts);
+
+    /* Hash directory (recursive) */
+    if (strncmp(argv[1], VALIDUS_CLI_DIR, 2) == 0) {
+        _validus_cli_open_cache(&opts);
+        return validus_cli_hash_dir(argv[2], &opts);
+    }
+
+    /* Compare signatures */
+    if (strncmp(argv[1], VALIDUS_CLI_DIFF, 2) == 0) {
+        if (argc < 4) {
+            _validus_cli_print_error("two signature files are required");
+            goto _print_usage;
+        }
+        return validus_cli_diff_signatures(argv[2], argv[3]);
+    }
+
+    /* Hash lines from stdin */
+    if (strncmp(argv[1], VALIDUS_CLI_BATCH, 2) == 0)
+        return validus_cli_hash_lines();
+
+    /* Verify manifest */
+    if (strncmp(argv[1], VALIDUS_CLI_CHECK, 2) == 0)
+        return validus_cli_verify_manifest(argv[2], &opts);
 
     /* Performance measurement */
     if (strncmp(argv[1], VALIDUS_CLI_PERF, 2) == 0)
@@ -70,31 +127,113 @@ int validus_cli_print_usage(void)
     fprintf(stderr, "\t" VALIDUS_CLI_STR " " ANSI_ULINE "string" ANSI_RESET
         " Hash string and output fingerprint\n");
     fprintf(stderr, "\t" VALIDUS_CLI_FILE " " ANSI_ULINE "file" ANSI_RESET
-        "   Hash file and output fingerprint\n");
+        "   Hash file ('" VALIDUS_CLI_STDIN "' for stdin) and output fingerprint\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_FILE " " ANSI_ULINE "file" ANSI_RESET " " ANSI_ULINE
+        "file" ANSI_RESET "... Hash files in parallel and output 'fingerprint  path' lines\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_TREE " " ANSI_ULINE "file" ANSI_RESET
+        "   Hash file in parallel tree mode and output root fingerprint\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_DIR " " ANSI_ULINE "dir" ANSI_RESET
+        "    Hash every file beneath dir and output 'fingerprint  path' lines\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_CHECK " " ANSI_ULINE "manifest" ANSI_RESET
+        " Verify the files listed in manifest (as output by " VALIDUS_CLI_DIR ")\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_DIFF " " ANSI_ULINE "old" ANSI_RESET " " ANSI_ULINE
+        "new" ANSI_RESET " Output 'offset length' of the ranges that differ between signatures\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_BATCH "        Hash each line of stdin and output one fingerprint per line\n");
     fprintf(stderr, "\t" VALIDUS_CLI_PERF "        Performance evaluation test\n");
     fprintf(stderr, "\t" VALIDUS_CLI_VS "        Verify that Validus is functioning correctly\n");
     fprintf(stderr, "\t" VALIDUS_CLI_VER "        Display version information\n");
     fprintf(stderr, "\t" VALIDUS_CLI_HELP "        Show this message\n");
+    fprintf(stderr, "\t(none)    Hash stdin, if it is not a terminal, and output fingerprint\n");
+    fprintf(stderr, ANSI_BOLD "options:" ANSI_RESET "\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_JOBS " " ANSI_ULINE "N" ANSI_RESET
+        "      Use N worker threads (with " VALIDUS_CLI_FILE ", " VALIDUS_CLI_TREE ", "
+        VALIDUS_CLI_DIR ", " VALIDUS_CLI_CHECK "; default: one per CPU)\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_MMAP "      Read files through a memory mapping\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_POPULATE "  Prefault the mapping (implies "
+        VALIDUS_CLI_MMAP ")\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_HUGEPAGES " Request huge pages for the mapping (implies "
+        VALIDUS_CLI_MMAP ")\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_ASYNC "     Overlap reading and hashing (io_uring or reader thread)\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_DIRECT "    Bypass the page cache (O_DIRECT, 1 MiB aligned reads)\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_NOCACHE "   Drop files from the page cache as they are read\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_CACHE " " ANSI_ULINE "path" ANSI_RESET
+        " Reuse fingerprints of unchanged files from the cache at path (default: $"
+        VALIDUS_CLI_CACHE_ENV ")\n"
+        "\t            (it holds at most 16M files, or " VALIDUS_CLI_CACHE_SLOTS "; the rest are not cached)\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_CACHE_SLOTS " " ANSI_ULINE "N" ANSI_RESET
+        " Size the cache for N (K, M or G) files, growing an existing one\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_NO_CACHE "  Use no fingerprint cache\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_REHASH "    Hash every file, and refresh its cache entry\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_APPEND " Hash only what was appended to files that have grown\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_BLOCKS " " ANSI_ULINE "size" ANSI_RESET
+        " Output a binary signature of each size (K, M or G) range (with " VALIDUS_CLI_FILE ")\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_FOLLOW " Follow symbolic links (with " VALIDUS_CLI_DIR ")\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_XDEV " Stay on the starting filesystem (with "
+        VALIDUS_CLI_DIR ")\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_STATS "     Print hot-path counters on exit (VALIDUS_STATS builds)\n");
+    fprintf(stderr, "\t" VALIDUS_CLI_END "          End of options: the arguments that follow are operands\n");
 
     return EXIT_FAILURE;
 }
 
 int validus_cli_print_ver(void)
 {
-    printf("%" PRIu16 ".%" PRIu16 ".%" PRIu16 "%s (%s)\n",
-        VERSION_MAJ, VERSION_MIN, VERSION_BLD, VERSION_TYPE, GIT_COMMIT_HASH);
+    printf("%" PRIu16 ".%" PRIu16 ".%" PRIu16 "%s (%s) [%s]\n",
+        VERSION_MAJ, VERSION_MIN, VERSION_BLD, VERSION_TYPE, GIT_COMMIT_HASH,
+        validus_kernel_name());
     return EXIT_SUCCESS;
 }
 
-int validus_cli_hash_file(const char *file)
+int validus_cli_hash_file(const char *file, const validus_cli_opts* opts)
 {
     if (!file || !*file) {
         _validus_cli_print_error("invalid file name supplied; ignoring.");
         return EXIT_FAILURE;
     }
 
+    if (0 == strcmp(file, VALIDUS_CLI_STDIN))
+        return validus_cli_hash_stdin(opts);
+
+    validus_state state = {0};
+    if (!validus_hash_file_opts(&state, file, &opts->io))
+        return EXIT_FAILURE;
+
+    printf(VALIDUS_FP_FMT_SPEC "\n", state.f0, state.f1, state.f2, state.f3,
+        state.f4, state.f5);
+
+    return EXIT_SUCCESS;
+}
+
+int validus_cli_hash_files(char* files[], size_t count, const validus_cli_opts* opts)
+{
+    validus_cli_files job = {0};
+    job.paths = files;
+    job.count = count;
+    job.opts  = opts;
+    job.files = calloc(count, sizeof(validus_cli_file));
+
+    if (!job.files) {
+        _validus_cli_print_error("failed to allocate memory: %d", errno);
+        return EXIT_FAILURE;
+    }
+
+    _validus_mutex_init(&job.lock);
+    bool ok = _validus_parallel_for(opts->jobs, count, &_validus_cli_hash_files_task, &job);
+    _validus_mutex_destroy(&job.lock);
+    fflush(stdout);
+
+    for (size_t n = 0; ok && n < count; n++)
+        ok = job.files[n].ok;
+
+    free(job.files);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int validus_cli_hash_stdin(const validus_cli_opts* opts)
+{
     validus_state state = {0};
-    if (!validus_hash_file(&state, file))
+    if (!_validus_hash_fd(&state, _validus_stdin(), "<stdin>", &opts->io))
         return EXIT_FAILURE;
 
     printf(VALIDUS_FP_FMT_SPEC "\n", state.f0, state.f1, state.f2, state.f3,
@@ -103,6 +242,223 @@ int validus_cli_hash_file(const char *file)
     return EXIT_SUCCESS;
 }
 
+int validus_cli_hash_file_tree(const char *file, const validus_cli_opts* opts)
+{
+    if (!file || !*file) {
+        _validus_cli_print_error("invalid file name supplied; ignoring.");
+        return EXIT_FAILURE;
+    }
+
+    validus_state state = {0};
+    if (!validus_tree_hash_file(&state, file, opts->jobs))
+        return EXIT_FAILURE;
+
+    printf(VALIDUS_FP_FMT_SPEC "\n", state.f0, state.f1, state.f2, state.f3,
+        state.f4, state.f5);
+
+    return EXIT_SUCCESS;
+}
+
+int validus_cli_hash_ranges(const char* file, const validus_cli_opts* opts)
+{
+    if (!file || !*file) {
+        _validus_cli_print_error("invalid file name supplied; ignoring.");
+        return EXIT_FAILURE;
+    }
+
+#if defined(__WIN__)
+    if (_isatty(_fileno(stdout))) {
+#else
+    if (isatty(STDOUT_FILENO)) {
+#endif
+        _validus_cli_print_error("not writing a binary signature to a terminal");
+        return EXIT_FAILURE;
+    }
+
+#if defined(__WIN__)
+    (void)_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    validus_signature sig = {0};
+    if (!validus_hash_ranges(&sig, file, opts->blocks, opts->jobs))
+        return EXIT_FAILURE;
+
+    bool ok = validus_signature_write(&sig, stdout);
+    if (!ok)
+        _validus_cli_print_error("failed to write the signature: %d", errno);
+
+    validus_signature_free(&sig);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int validus_cli_diff_signatures(const char* old_sig, const char* new_sig)
+{
+    validus_signature old_ranges = {0}, new_ranges = {0};
+    int retval = EXIT_FAILURE;
+
+    if (!_validus_cli_read_signature(&old_ranges, old_sig) ||
+        !_validus_cli_read_signature(&new_ranges, new_sig))
+        goto _cleanup;
+
+    if (!validus_signature_diff(&old_ranges, &new_ranges, &_validus_cli_print_range, NULL)) {
+        _validus_cli_print_error("signatures of different range sizes (%" PRIu64 " and %"
+            PRIu64 ") cannot be compared", old_ranges.range_size, new_ranges.range_size);
+        goto _cleanup;
+    }
+
+    fflush(stdout);
+    retval = EXIT_SUCCESS;
+
+_cleanup:
+    validus_signature_free(&old_ranges);
+    validus_signature_free(&new_ranges);
+
+    return retval;
+}
+
+int validus_cli_hash_dir(const char* dir, const validus_cli_opts* opts)
+{
+    if (!dir || !*dir) {
+        _validus_cli_print_error("invalid directory name supplied; ignoring.");
+        return EXIT_FAILURE;
+    }
+
+    bool ok = validus_hash_dir(dir, opts->dir_flags, &opts->io, opts->jobs,
+        &_validus_cli_print_dir_entry, NULL);
+    fflush(stdout);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int validus_cli_verify_manifest(const char* manifest, const validus_cli_opts* opts)
+{
+    if (!manifest || !*manifest) {
+        _validus_cli_print_error("invalid manifest name supplied; ignoring.");
+        return EXIT_FAILURE;
+    }
+
+    validus_verify_totals totals = {0};
+    /* the cache is not consulted: verification is meant to find corruption
+     * that leaves a file's metadata untouched. */
+    bool ok = validus_verify_manifest(manifest, opts->io.flags, opts->jobs,
+        &_validus_cli_print_verify_failure, NULL, &totals);
+
+    if (ok) {
+        printf("%zu files OK\n", totals.passed);
+    } else if (totals.entries > 0 || totals.malformed > 0) {
+        printf("%zu of %zu files OK: %zu mismatched, %zu unreadable, %zu malformed lines\n",
+            totals.passed, totals.entries, totals.mismatched, totals.unreadable,
+            totals.malformed);
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int validus_cli_hash_lines(void)
+{
+#if defined(__WIN__)
+    validus_fd in = GetStdHandle(STD_INPUT_HANDLE);
+#else
+    validus_fd in = STDIN_FILENO;
+#endif
+
+    size_t cap  = VALIDUS_CLI_BATCH_READSIZE;
+    char* buf   = malloc(cap);
+    char* out   = malloc(VALIDUS_CLI_BATCH_OUTSIZE);
+    size_t have = 0, used = 0;
+    bool eof    = false, ok = true;
+
+    const void* data[VALIDUS_CLI_BATCH_LINES];
+    size_t lens[VALIDUS_CLI_BATCH_LINES];
+    validus_state states[VALIDUS_CLI_BATCH_LINES];
+
+    if (!buf || !out) {
+        _validus_cli_print_error("failed to allocate memory: %d", errno);
+        free(buf);
+        free(out);
+        return EXIT_FAILURE;
+    }
+
+    while (ok && !eof) {
+        if (have == cap) {
+            /* a line longer than the buffer. */
+            char* grown = realloc(buf, cap * 2);
+            if (!grown) {
+                _validus_cli_print_error("failed to allocate memory: %d", errno);
+                ok = false;
+                break;
+            }
+            buf  = grown;
+            cap *= 2;
+        }
+
+        size_t got = 0;
+        if (!_validus_file_read(in, buf + have, cap - have, &got)) {
+            ok = false;
+            break;
+        }
+
+        eof   = 0 == got;
+        have += got;
+
+        /* lines are hashed in place; the newline is not part of the line. */
+        size_t start = 0, count = 0;
+        for (;;) {
+            const char* nl = memchr(buf + start, '\n', have - start);
+            bool last      = !nl && eof && start < have;
+
+            if (nl || last) {
+                size_t end    = nl ? (size_t)(nl - buf) : have;
+                data[count]   = buf + start;
+                lens[count++] = end - start;
+                start         = nl ? end + 1 : have;
+            }
+
+            if (count == VALIDUS_CLI_BATCH_LINES || (!nl && count > 0)) {
+                (void)validus_hash_many(states, data, lens, count);
+
+                for (size_t n = 0; n < count; n++) {
+                    if (used + VALIDUS_FP_SIZE_O + 1 > VALIDUS_CLI_BATCH_OUTSIZE) {
+                        if (used != fwrite(out, 1, used, stdout)) {
+                            ok = false;
+                            break;
+                        }
+                        used = 0;
+                    }
+                    char* end = _validus_cli_format_fp(out + used, &states[n]);
+                    *end++    = '\n';
+                    used      = (size_t)(end - out);
+                }
+                count = 0;
+            }
+
+            if (!ok)
+                break;
+
+            if (!nl)
+                break;
+        }
+
+        memmove(buf, buf + start, have - start);
+        have -= start;
+    }
+
+    if (ok)
+        (void)fwrite(out, 1, used, stdout);
+
+    /* a short write (here or above) leaves the error indicator set. */
+    if (0 != fflush(stdout) || ferror(stdout)) {
+        _validus_cli_print_error("failed to write the fingerprints: %d", errno);
+        ok = false;
+    }
+
+    free(buf);
+    free(out);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int validus_cli_hash_string(const char *string)
 {
     if (!string || !*string) {
@@ -136,6 +492,11 @@ int validus_cli_perf_test(void)
 
     validus_timer timer = {0};
     validus_state state = {0};
+    validus_perf perf;
+    bool counters = validus_perf_open(&perf);
+
+    if (counters)
+        validus_perf_start(&perf);
 
     validus_timer_start(&timer);
     validus_init(&state);
@@ -146,6 +507,9 @@ int validus_cli_perf_test(void)
     validus_finalize(&state);
 
     double elapsed_msec = validus_timer_elapsed(&timer);
+
+    if (counters)
+        validus_perf_stop(&perf);
     double bps = (double)(VALIDUS_CLI_PERF_BLKS * VALIDUS_CLI_PERF_BLKSIZE)
         / (elapsed_msec / 1e3);
     double mbs = bps / 1024.0 / 1024.0;
@@ -155,9 +519,37 @@ int validus_cli_perf_test(void)
            (elapsed_msec / 1e3), mbs, state.f0, state.f1, state.f2, state.f3,
            state.f4, state.f5);
 
+    if (counters) {
+        validus_cli_print_counters(&perf, VALIDUS_CLI_PERF_BLKS *
+            ((VALIDUS_CLI_PERF_BLKSIZE + VALIDUS_FP_SIZE_B - 1) / VALIDUS_FP_SIZE_B) + 1);
+        validus_perf_close(&perf);
+    }
+
     return EXIT_SUCCESS;
 }
 
+void validus_cli_print_counters(const validus_perf* perf, uint64_t blocks)
+{
+    static const char* const names[VALIDUS_PERF_NCOUNTERS] = {
+        "cycles", "instructions", "L1-icache misses", "branch misses"
+    };
+
+    printf("\tper %d-octet block (%" PRIu64 " blocks):\n", VALIDUS_FP_SIZE_B, blocks);
+
+    for (size_t n = 0; n < VALIDUS_PERF_NCOUNTERS; n++) {
+        if (validus_perf_has(perf, (validus_perf_counter)n))
+            printf("\t\t%s: %.3f\n", names[n], (double)perf->values[n] / (double)blocks);
+        else
+            printf("\t\t%s: unavailable\n", names[n]);
+    }
+
+    if (validus_perf_has(perf, VALIDUS_PERF_CYCLES) &&
+        validus_perf_has(perf, VALIDUS_PERF_INSTRUCTIONS) &&
+        perf->values[VALIDUS_PERF_CYCLES] > 0ULL)
+        printf("\t\tIPC: %.2f\n", (double)perf->values[VALIDUS_PERF_INSTRUCTIONS] /
+            (double)perf->values[VALIDUS_PERF_CYCLES]);
+}
+
 void print_test_result(bool result, const validus_state* state, const char* input) {
     const int color = result ? 32 : 31;
     static const size_t longest_input = 12;
@@ -212,9 +604,465 @@ int validus_cli_verify_sanity(void)
         all_pass &= pass;
     }
 
+    /* every kernel the CPU supports must agree with the known answers, and
+     * its multi-buffer and streaming paths with its one-shot path. */
+    validus_octet* buf = malloc(VALIDUS_CLI_SANITY_TREESIZE);
+    if (!buf) {
+        _validus_cli_print_error("failed to allocate memory: %d", errno);
+        return EXIT_FAILURE;
+    }
+
+    uint32_t seed = 0x9e3779b9U;
+    for (size_t n = 0; n < VALIDUS_CLI_SANITY_TREESIZE; n++) {
+        seed   = seed * 1664525U + 1013904223U;
+        buf[n] = (validus_octet)(seed >> 24);
+    }
+
+    const validus_kernel* selected = _validus_kernel();
+    const validus_kernel* kernel   = NULL;
+
+    for (size_t k = 0; NULL != (kernel = _validus_kernel_at(k)); k++) {
+        if (!_validus_kernel_supported(kernel))
+            continue;
+
+        (void)_validus_kernel_use(kernel);
+
+        bool pass = _validus_cli_check_kernel(buf) && _validus_cli_check_keyed(buf);
+        for (size_t n = 0; n < VALIDUS_CLI_SANITY_INPUTS; ++n) {
+            validus_hash_string(&state, test_inputs[n].str);
+            pass &= validus_compare(&state, &test_inputs[n].kv);
+        }
+
+        printf(ANSI_WHITE VALIDUS_CLI_NAME " kernel '%s'%*s= " ANSI_ESC "%dm%s" ANSI_RESET "\n",
+            kernel->name, (int)(10 - strlen(kernel->name)), "", pass ? 32 : 31,
+            pass ? "pass" : "FAIL");
+        all_pass &= pass;
+    }
+
+    (void)_validus_kernel_use(selected);
+
+    bool pass = _validus_cli_check_tree(buf);
+    printf(ANSI_WHITE VALIDUS_CLI_NAME " tree mode%*s= " ANSI_ESC "%dm%s" ANSI_RESET "\n",
+        10, "", pass ? 32 : 31, pass ? "pass" : "FAIL");
+    all_pass &= pass;
+
+#if !defined(__WIN__)
+    pass = _validus_cli_check_cache(buf);
+    printf(ANSI_WHITE VALIDUS_CLI_NAME " cache%*s= " ANSI_ESC "%dm%s" ANSI_RESET "\n",
+        14, "", pass ? 32 : 31, pass ? "pass" : "FAIL");
+    all_pass &= pass;
+#endif
+
+    free(buf);
+
     return all_pass ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
+bool _validus_cli_check_kernel(const validus_octet* buf)
+{
+    static const size_t chunks[] = {1, 7, 64, 191, 192, 193, 1000};
+
+    bool pass = true;
+    validus_state expected, actual;
+
+    /* validus_hash_many: lengths from 0 to over three blocks, at odd offsets. */
+    validus_state states[VALIDUS_CLI_SANITY_MESSAGES];
+    const void* data[VALIDUS_CLI_SANITY_MESSAGES];
+    size_t lens[VALIDUS_CLI_SANITY_MESSAGES];
+
+    for (size_t n = 0; n < VALIDUS_CLI_SANITY_MESSAGES; n++) {
+        data[n] = buf + n;
+        lens[n] = (n * 97U) % VALIDUS_CLI_SANITY_MAXLEN;
+    }
+
+    pass &= validus_hash_many(states, data, lens, VALIDUS_CLI_SANITY_MESSAGES);
+    for (size_t n = 0; n < VALIDUS_CLI_SANITY_MESSAGES; n++) {
+        /* validus_hash_mem refuses empty input; this is what it would do. */
+        validus_init(&expected);
+        validus_append(&expected, data[n], lens[n]);
+        validus_finalize(&expected);
+        pass &= validus_compare(&states[n], &expected);
+    }
+
+    /* validus_stream_write, in chunks that straddle block boundaries. */
+    validus_hash_mem(&expected, buf, VALIDUS_CLI_SANITY_BUFSIZE);
+
+    for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        validus_stream stream;
+        validus_stream_init(&stream);
+
+        for (size_t off = 0; off < VALIDUS_CLI_SANITY_BUFSIZE; off += chunks[c]) {
+            size_t len = VALIDUS_CLI_SANITY_BUFSIZE - off < chunks[c]
+                ? VALIDUS_CLI_SANITY_BUFSIZE - off : chunks[c];
+            validus_stream_write(&stream, buf + off, len);
+        }
+
+        validus_stream_finalize(&stream);
+        pass &= validus_compare(&stream.state, &expected);
+    }
+
+    /* a stream serialized with a partial block buffered, and resumed. */
+    validus_octet saved[VALIDUS_STREAM_SERIALIZED_MAX];
+    validus_stream before, after;
+    validus_stream_init(&before);
+    validus_stream_write(&before, buf, 1000);
+
+    size_t len = validus_stream_serialize(&before, saved, sizeof(saved));
+    pass &= len > 0 && validus_stream_deserialize(&after, saved, len);
+    if (pass) {
+        validus_stream_write(&after, buf + 1000, VALIDUS_CLI_SANITY_BUFSIZE - 1000);
+        validus_stream_finalize(&after);
+        pass &= validus_compare(&after.state, &expected);
+    }
+
+    /* and a finalized state. */
+    pass &= validus_state_serialize(&expected, saved, sizeof(saved)) == VALIDUS_STATE_SERIALIZED_SIZE &&
+        validus_state_deserialize(&actual, saved, VALIDUS_STATE_SERIALIZED_SIZE) &&
+        validus_compare(&actual, &expected);
+
+    return pass;
+}
+
+bool _validus_cli_check_keyed(const validus_octet* buf)
+{
+    static const size_t keylens[] = {0, 1, 191, 192, 193, 500};
+    static const size_t msglens[] = {0, 1, 192, VALIDUS_CLI_SANITY_MAXLEN};
+    static const size_t chunks[]  = {1, 7, 64, 191, 192, 193, 1000};
+
+    bool pass = true;
+    validus_keyed keyed;
+    validus_state expected, actual;
+    validus_octet block[VALIDUS_FP_SIZE_B];
+    validus_octet msg[VALIDUS_FP_SIZE_B + VALIDUS_CLI_SANITY_MAXLEN];
+
+    /* the keys are taken from past the longest message. */
+    const validus_octet* key = buf + VALIDUS_CLI_SANITY_MAXLEN;
+
+    for (size_t k = 0; k < sizeof(keylens) / sizeof(keylens[0]); k++) {
+        pass &= validus_keyed_init(&keyed, key, keylens[k]);
+
+        /* the key block: the key (or, if longer than a block, its fingerprint),
+         * zero-padded. */
+        memset(block, 0, sizeof(block));
+        if (keylens[k] > VALIDUS_FP_SIZE_B) {
+            validus_hash_mem(&expected, key, keylens[k]);
+            _validus_fp_store(block, &expected);
+        } else if (keylens[k] > 0) {
+            memcpy(block, key, keylens[k]);
+        }
+
+        /* validus_keyed_hash is H((K ^ opad) || H((K ^ ipad) || m)), with the
+         * inner fingerprint serialized little-endian. */
+        for (size_t m = 0; m < sizeof(msglens) / sizeof(msglens[0]); m++) {
+            for (size_t n = 0; n < VALIDUS_FP_SIZE_B; n++)
+                msg[n] = block[n] ^ 0x36U;
+            memcpy(msg + VALIDUS_FP_SIZE_B, buf, msglens[m]);
+            validus_hash_mem(&expected, msg, VALIDUS_FP_SIZE_B + msglens[m]);
+
+            for (size_t n = 0; n < VALIDUS_FP_SIZE_B; n++)
+                msg[n] = block[n] ^ 0x5CU;
+            _validus_fp_store(msg + VALIDUS_FP_SIZE_B, &expected);
+            validus_hash_mem(&expected, msg, VALIDUS_FP_SIZE_B + VALIDUS_FP_OCTETS);
+
+            pass &= validus_keyed_hash(&keyed, &actual, buf, msglens[m]) &&
+                validus_compare(&actual, &expected);
+        }
+
+        /* validus_keyed_start and validus_keyed_finalize, in chunks. */
+        pass &= validus_keyed_hash(&keyed, &expected, buf, VALIDUS_CLI_SANITY_BUFSIZE);
+
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            validus_stream stream;
+            pass &= validus_keyed_start(&keyed, &stream);
+
+            for (size_t off = 0; off < VALIDUS_CLI_SANITY_BUFSIZE; off += chunks[c]) {
+                size_t len = VALIDUS_CLI_SANITY_BUFSIZE - off < chunks[c]
+                    ? VALIDUS_CLI_SANITY_BUFSIZE - off : chunks[c];
+                validus_stream_write(&stream, buf + off, len);
+            }
+
+            pass &= validus_keyed_finalize(&keyed, &stream) &&
+                validus_compare(&stream.state, &expected);
+        }
+
+        validus_keyed_wipe(&keyed);
+    }
+
+    /* validus_compare_ct agrees with validus_compare, whichever word differs
+     * (the bit count is not part of a fingerprint). */
+    pass &= validus_compare_ct(&expected, &expected);
+
+    for (size_t w = 0; w < 7; w++) {
+        actual = expected;
+        validus_word* words[] = {&actual.f0, &actual.f1, &actual.f2, &actual.f3,
+            &actual.f4, &actual.f5, &actual.bits[0]};
+        *words[w] ^= 0x80000000U;
+        pass &= validus_compare_ct(&actual, &expected) == validus_compare(&actual, &expected);
+    }
+
+    return pass;
+}
+
+bool _validus_cli_check_tree(const validus_octet* buf)
+{
+    typedef struct {
+        const void* mem;
+        size_t len;
+        validus_state kv;
+    } tree_value;
+
+    const tree_value tree_inputs[] = {
+        {"", 0,
+            {{0}, 0xff957819U, 0xd84667beU, 0x16fe2767U, 0x7f49172eU, 0x9ed0953cU, 0xa57817faU}},
+        {"abc", 3,
+            {{0}, 0x0d68ba63U, 0x442d7834U, 0x5dada844U, 0x6c38fb33U, 0x21b62d32U, 0xf3582e8fU}},
+        {buf, VALIDUS_CLI_SANITY_TREESIZE,
+            {{0}, 0x7932660bU, 0x29c5c8feU, 0xe5ee6e76U, 0xa4141b23U, 0x29c18564U, 0xe2c42d3cU}}
+    };
+
+    bool pass = true;
+    validus_state state;
+
+    /* the root does not depend on how many workers hash the leaves. */
+    for (size_t n = 0; n < sizeof(tree_inputs) / sizeof(tree_inputs[0]); n++) {
+        for (size_t threads = 1; threads <= 3; threads++) {
+            pass &= validus_tree_hash_mem(&state, tree_inputs[n].mem, tree_inputs[n].len, threads) &&
+                validus_compare(&state, &tree_inputs[n].kv);
+        }
+    }
+
+    return pass;
+}
+
+#if !defined(__WIN__)
+bool _validus_cli_check_cache(const validus_octet* buf)
+{
+    const char* tmp = getenv("TMPDIR");
+    char dir[PATH_MAX - 16], file[PATH_MAX], path[PATH_MAX];
+
+    if (snprintf(dir, sizeof(dir), "%s/validus.XXXXXX", tmp && *tmp ? tmp : "/tmp") >= (int)sizeof(dir) ||
+        !mkdtemp(dir)) {
+        _validus_cli_print_error("failed to create a temporary directory: %d", errno);
+        return false;
+    }
+
+    (void)snprintf(file, sizeof(file), "%s/file", dir);
+    (void)snprintf(path, sizeof(path), "%s/cache", dir);
+
+    validus_cache* cache = validus_cache_open(path, 16);
+    int fd = open(file, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+
+    /* `contents` mirrors the file, as the full hash to compare against. */
+    const size_t part = VALIDUS_CLI_SANITY_GROWTH;
+    validus_octet contents[5 * VALIDUS_CLI_SANITY_GROWTH];
+    memcpy(contents, buf, sizeof(contents));
+
+    validus_io_options append = {VALIDUS_IO_APPEND, 0, cache};
+    validus_io_options rehash = {VALIDUS_IO_APPEND | VALIDUS_IO_REHASH, 0, cache};
+    validus_state expected, actual;
+    bool pass = NULL != cache && fd >= 0;
+
+#define _VALIDUS_CLI_WRITE(off, len) \
+    (pass && (ssize_t)(len) == pwrite(fd, &contents[off], (len), (off_t)(off)))
+#define _VALIDUS_CLI_HASHES_TO(opts, len) \
+    (pass && validus_hash_mem(&expected, contents, (len)) && \
+        validus_hash_file_opts(&actual, file, &(opts)) && validus_compare(&actual, &expected))
+
+    /* grown, with its old end unchanged: resumed, as if hashed in full. */
+    pass = _VALIDUS_CLI_WRITE(0, part) && _VALIDUS_CLI_HASHES_TO(append, part);
+    pass = _VALIDUS_CLI_WRITE(part, part) && _VALIDUS_CLI_HASHES_TO(append, 2 * part) &&
+        _VALIDUS_CLI_HASHES_TO(rehash, 2 * part);
+
+    /* a change before the tail that is compared is seen with VALIDUS_IO_REHASH,
+     * but not by a resumed hash (which shows that it was resumed). */
+    contents[0] ^= 0x01U;
+    pass = _VALIDUS_CLI_WRITE(0, 1) && _VALIDUS_CLI_WRITE(2 * part, part) &&
+        _VALIDUS_CLI_HASHES_TO(rehash, 3 * part);
+
+    contents[1] ^= 0x01U;
+    pass = _VALIDUS_CLI_WRITE(1, 1);
+    contents[1] ^= 0x01U;
+    pass = _VALIDUS_CLI_WRITE(3 * part, part) && _VALIDUS_CLI_HASHES_TO(append, 4 * part);
+    contents[1] ^= 0x01U;
+
+    /* a changed tail, or a smaller size, is hashed in full. */
+    const size_t tail = 4 * part - VALIDUS_RESUME_TAIL / 2;
+    contents[tail] ^= 0x01U;
+    pass = _VALIDUS_CLI_WRITE(tail, 1) && _VALIDUS_CLI_WRITE(4 * part, part) &&
+        _VALIDUS_CLI_HASHES_TO(append, 5 * part);
+    pass = pass && 0 == ftruncate(fd, (off_t)(4 * part)) && _VALIDUS_CLI_HASHES_TO(append, 4 * part);
+
+#undef _VALIDUS_CLI_HASHES_TO
+#undef _VALIDUS_CLI_WRITE
+
+    if (fd >= 0)
+        (void)close(fd);
+    if (cache)
+        validus_cache_close(cache);
+
+    (void)unlink(file);
+    (void)unlink(path);
+    (void)rmdir(dir);
+
+    return pass;
+}
+#endif
+
+int _validus_cli_operands(const char* mode)
+{
+    if (strncmp(mode, VALIDUS_CLI_DIFF, 2) == 0)
+        return 2;
+
+    if (strncmp(mode, VALIDUS_CLI_STR, 2) == 0 || strncmp(mode, VALIDUS_CLI_FILE, 2) == 0 ||
+        strncmp(mode, VALIDUS_CLI_TREE, 2) == 0 || strncmp(mode, VALIDUS_CLI_DIR, 2) == 0 ||
+        strncmp(mode, VALIDUS_CLI_CHECK, 2) == 0)
+        return 1;
+
+    return 0;
+}
+
+bool _validus_cli_parse_opts(int* argc, char* argv[], validus_cli_opts* opts)
+{
+    int kept     = 1;
+    int operands = 0;    /* arguments to keep as they are, whatever they look like. */
+    bool parsing = true; /* until a literal "--". */
+
+    for (int n = 1; n < *argc; n++) {
+        if (operands > 0 || !parsing) {
+            operands -= operands > 0 ? 1 : 0;
+            argv[kept++] = argv[n];
+            continue;
+        }
+
+        if (strcmp(argv[n], VALIDUS_CLI_END) == 0) {
+            parsing = false;
+            continue;
+        }
+
+        /* -j N, or -jN (but not, say, "-jfoo"). */
+        if (strcmp(argv[n], VALIDUS_CLI_JOBS) == 0 || (strncmp(argv[n], VALIDUS_CLI_JOBS, 2) == 0 &&
+            strspn(&argv[n][2], "0123456789") == strlen(&argv[n][2]))) {
+            const char* value  = argv[n][2] ? &argv[n][2] : (n + 1 < *argc ? argv[++n] : "");
+            char* end          = NULL;
+            unsigned long jobs = strtoul(value, &end, 10);
+
+            if (!*value || *end || 0UL == jobs || '-' == *value) {
+                _validus_cli_print_error("invalid number of jobs: '%s'", value);
+                return false;
+            }
+
+            opts->jobs = (size_t)jobs;
+            continue;
+        }
+
+        if (strncmp(argv[n], "--", 2) != 0) {
+            /* the mode's own operands are never taken for options. */
+            if (1 == kept)
+                operands = _validus_cli_operands(argv[n]);
+            argv[kept++] = argv[n];
+            continue;
+        }
+
+        if (strcmp(argv[n], VALIDUS_CLI_MMAP) == 0) {
+            opts->io.flags |= VALIDUS_IO_MMAP;
+        } else if (strcmp(argv[n], VALIDUS_CLI_POPULATE) == 0) {
+            opts->io.flags |= VALIDUS_IO_MMAP | VALIDUS_IO_POPULATE;
+        } else if (strcmp(argv[n], VALIDUS_CLI_HUGEPAGES) == 0) {
+            opts->io.flags |= VALIDUS_IO_MMAP | VALIDUS_IO_HUGEPAGES;
+        } else if (strcmp(argv[n], VALIDUS_CLI_ASYNC) == 0) {
+            opts->io.flags |= VALIDUS_IO_ASYNC;
+        } else if (strcmp(argv[n], VALIDUS_CLI_DIRECT) == 0) {
+            opts->io.flags |= VALIDUS_IO_DIRECT;
+        } else if (strcmp(argv[n], VALIDUS_CLI_NOCACHE) == 0) {
+            opts->io.flags |= VALIDUS_IO_SEQUENTIAL | VALIDUS_IO_NOCACHE;
+        } else if (strcmp(argv[n], VALIDUS_CLI_CACHE) == 0) {
+            if (n + 1 >= *argc) {
+                _validus_cli_print_error("no path supplied for " VALIDUS_CLI_CACHE);
+                return false;
+            }
+            opts->cache = argv[++n];
+        } else if (strcmp(argv[n], VALIDUS_CLI_CACHE_SLOTS) == 0) {
+            const char* value = n + 1 < *argc ? argv[++n] : "";
+            if (!_validus_cli_parse_size(value, &opts->cache_slots) || 0ULL == opts->cache_slots ||
+                opts->cache_slots > (1ULL << 32)) {
+                _validus_cli_print_error("invalid number of cache slots: '%s'", value);
+                return false;
+            }
+        } else if (strcmp(argv[n], VALIDUS_CLI_NO_CACHE) == 0) {
+            opts->no_cache = true;
+        } else if (strcmp(argv[n], VALIDUS_CLI_REHASH) == 0) {
+            opts->io.flags |= VALIDUS_IO_REHASH;
+        } else if (strcmp(argv[n], VALIDUS_CLI_APPEND) == 0) {
+            opts->io.flags |= VALIDUS_IO_APPEND;
+        } else if (strcmp(argv[n], VALIDUS_CLI_BLOCKS) == 0) {
+            const char* value = n + 1 < *argc ? argv[++n] : "";
+            if (!_validus_cli_parse_size(value, &opts->blocks) || 0ULL == opts->blocks) {
+                _validus_cli_print_error("invalid range size: '%s'", value);
+                return false;
+            }
+        } else if (strcmp(argv[n], VALIDUS_CLI_FOLLOW) == 0) {
+            opts->dir_flags |= VALIDUS_DIR_FOLLOW;
+        } else if (strcmp(argv[n], VALIDUS_CLI_XDEV) == 0) {
+            opts->dir_flags |= VALIDUS_DIR_XDEV;
+        } else if (strcmp(argv[n], VALIDUS_CLI_STATS) == 0) {
+            opts->stats = true;
+        } else {
+            _validus_cli_print_error("unknown option: '%s'", argv[n]);
+            return false;
+        }
+    }
+
+    argv[kept] = NULL;
+    *argc      = kept;
+
+    return true;
+}
+
+bool _validus_cli_parse_size(const char* str, uint64_t* size)
+{
+    if (!str || !*str || '-' == *str)
+        return false;
+
+    char* end             = NULL;
+    unsigned long long n  = strtoull(str, &end, 10);
+    unsigned int shift    = 0;
+
+    switch (*end) {
+        case 'K': case 'k': shift = 10; end++; break;
+        case 'M': case 'm': shift = 20; end++; break;
+        case 'G': case 'g': shift = 30; end++; break;
+        default: break;
+    }
+
+    if (end == str || *end || n > (UINT64_MAX >> shift))
+        return false;
+
+    *size = (uint64_t)n << shift;
+    return true;
+}
+
+bool _validus_cli_read_signature(validus_signature* sig, const char* path)
+{
+    FILE* in = path && *path ? fopen(path, "rb") : NULL;
+    if (!in) {
+        _validus_cli_print_error("failed to open '%s': %d", path ? path : "", errno);
+        return false;
+    }
+
+    bool ok = validus_signature_read(sig, in);
+    if (!ok)
+        _validus_cli_print_error("'%s' is not a valid signature file", path);
+
+    fclose(in);
+    return ok;
+}
+
+void _validus_cli_print_range(void* ctx, uint64_t offset, uint64_t len)
+{
+    (void)ctx;
+    printf("%" PRIu64 " %" PRIu64 "\n", offset, len);
+}
+
 void _validus_cli_print_error(const char* format, ...)
 {
     if (!format || !*format)
@@ -230,3 +1078,129 @@ void _validus_cli_print_error(const char* format, ...)
     fprintf(stderr, "%s%s%s%s", ANSI_RED, VALIDUS_CLI_NAME ": ", buf,
         ANSI_RESET "\n");
 }
+
+void _validus_cli_hash_files_task(void* ctx, size_t worker, size_t idx)
+{
+    validus_cli_files* job = (validus_cli_files*)ctx;
+    validus_cli_file* file = &job->files[idx];
+    const char* path       = job->paths[idx];
+    (void)worker;
+
+    /* failures are reported on stderr, and do not stop the other files. */
+    if (0 == strcmp(path, VALIDUS_CLI_STDIN))
+        file->ok = _validus_hash_fd(&file->state, _validus_stdin(), "<stdin>", &job->opts->io);
+    else
+        file->ok = validus_hash_file_opts(&file->state, path, &job->opts->io);
+
+    _validus_mutex_lock(&job->lock);
+    file->done = true;
+
+    while (job->printed < job->count && job->files[job->printed].done) {
+        _validus_cli_print_dir_entry(NULL, job->paths[job->printed],
+            job->files[job->printed].ok ? &job->files[job->printed].state : NULL);
+        job->printed++;
+    }
+
+    _validus_mutex_unlock(&job->lock);
+}
+
+/** Whether `path` has characters that ::_validus_cli_print_path escapes. */
+bool _validus_cli_needs_escape(const char* path)
+{
+    return NULL != strpbrk(path, "\\\n\r");
+}
+
+/** Prints `path` with backslashes, newlines and carriage returns escaped. */
+void _validus_cli_print_path(const char* path)
+{
+    for (; *path; path++) {
+        switch (*path) {
+            case '\\': fputs("\\\\", stdout); break;
+            case '\n': fputs("\\n", stdout); break;
+            case '\r': fputs("\\r", stdout); break;
+            default: putchar(*path); break;
+        }
+    }
+}
+
+void _validus_cli_print_dir_entry(void* ctx, const char* path, const validus_state* state)
+{
+    (void)ctx;
+
+    /* failures have already been reported on stderr. as with sha256sum, a
+     * line whose path has a backslash, newline or carriage return in it
+     * starts with a backslash, and they are escaped. */
+    if (state) {
+        printf("%s" VALIDUS_FP_FMT_SPEC "  ", _validus_cli_needs_escape(path) ? "\\" : "",
+            state->f0, state->f1, state->f2, state->f3, state->f4, state->f5);
+        _validus_cli_print_path(path);
+        putchar('\n');
+    }
+}
+
+void _validus_cli_print_verify_failure(void* ctx, const char* path,
+    const validus_state* expected, const validus_state* actual)
+{
+    (void)ctx;
+    (void)expected;
+
+    if (_validus_cli_needs_escape(path))
+        putchar('\\');
+    _validus_cli_print_path(path);
+    printf(": FAILED%s\n", actual ? "" : " (unreadable)");
+}
+
+void _validus_cli_print_stats(void)
+{
+    validus_stats stats;
+    if (!validus_stats_get(&stats)) {
+        _validus_cli_print_error("counters are not collected (build with -DVALIDUS_STATS=ON)");
+        return;
+    }
+
+    fprintf(stderr, "bytes: %" PRIu64 "\nfull blocks: %" PRIu64 "\npadded tails: %" PRIu64
+        "\nunaligned copies: %" PRIu64 "\nfinalize calls: %" PRIu64 "\nfile I/O: %.3f ms"
+        "\nfile compute: %.3f ms\n", stats.bytes, stats.full_blocks, stats.padded_tails,
+        stats.unaligned, stats.finalizes, (double)stats.io_ns / 1e6,
+        (double)stats.compute_ns / 1e6);
+}
+
+void _validus_cli_open_cache(validus_cli_opts* opts)
+{
+    const char* path = opts->no_cache ? NULL
+        : (opts->cache ? opts->cache : getenv(VALIDUS_CLI_CACHE_ENV));
+
+    if (!path || !*path)
+        return;
+
+    /* without its cache, the work is the same; it just takes longer. */
+    opts->io.cache = validus_cache_open(path, (size_t)opts->cache_slots);
+    if (!opts->io.cache) {
+        _validus_cli_print_error("continuing without the cache '%s'", path);
+        return;
+    }
+
+    _validus_cli_cache = opts->io.cache;
+    (void)atexit(&_validus_cli_close_cache);
+}
+
+void _validus_cli_close_cache(void)
+{
+    validus_cache_close(_validus_cli_cache);
+    _validus_cli_cache = NULL;
+}
+
+char* _validus_cli_format_fp(char* out, const validus_state* state)
+{
+    static const char digits[] = "0123456789abcdef";
+    const validus_word words[6] = {
+        state->f0, state->f1, state->f2, state->f3, state->f4, state->f5
+    };
+
+    for (size_t n = 0; n < 6; n++) {
+        for (int shift = 28; shift >= 0; shift -= 4)
+            *out++ = digits[(words[n] >> shift) & 0xfU];
+    }
+
+    return out;
+}
@@ -28,6 +28,10 @@
 # define _VALIDUS_CLI_H_INCLUDED
 
 # include "validusutil.h"
+# include "validusperf.h"
+# include "validusio.h"
+# include "validuspool.h"
+# include "validuskernel.h"
 # include <stdio.h>
 # include <stdlib.h>
 # include <stdarg.h>
@@ -35,6 +39,12 @@
 
 # if defined(__WIN__)
 #  include <conio.h>
+#  include <io.h>
+#  include <fcntl.h>
+# else
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <limits.h>
 # endif
 
 /////////////////////////////// constants //////////////////////////////////////
@@ -42,11 +52,38 @@
 # define VALIDUS_CLI_HELP "-h"
 # define VALIDUS_CLI_STR  "-s"
 # define VALIDUS_CLI_FILE "-f"
+# define VALIDUS_CLI_TREE "-T"
+# define VALIDUS_CLI_DIR  "-r"
+# define VALIDUS_CLI_CHECK "-c"
+# define VALIDUS_CLI_DIFF "-d"
+# define VALIDUS_CLI_BATCH "-b"
 # define VALIDUS_CLI_PERF "-p"
 # define VALIDUS_CLI_VS   "-t"
 # define VALIDUS_CLI_VER  "-v"
+# define VALIDUS_CLI_JOBS "-j"
+# define VALIDUS_CLI_END  "--"
+
+# define VALIDUS_CLI_MMAP      "--mmap"
+# define VALIDUS_CLI_POPULATE  "--populate"
+# define VALIDUS_CLI_HUGEPAGES "--hugepages"
+# define VALIDUS_CLI_ASYNC     "--async"
+# define VALIDUS_CLI_DIRECT    "--direct"
+# define VALIDUS_CLI_NOCACHE   "--nocache"
+# define VALIDUS_CLI_CACHE     "--cache"
+# define VALIDUS_CLI_CACHE_SLOTS "--cache-slots"
+# define VALIDUS_CLI_NO_CACHE  "--no-cache"
+# define VALIDUS_CLI_REHASH    "--rehash"
+# define VALIDUS_CLI_APPEND    "--append-only"
+# define VALIDUS_CLI_BLOCKS    "--blocks"
+
+/** The environment variable naming the default fingerprint cache. */
+# define VALIDUS_CLI_CACHE_ENV "VALIDUS_CACHE"
+# define VALIDUS_CLI_FOLLOW    "--follow-symlinks"
+# define VALIDUS_CLI_XDEV      "--one-file-system"
+# define VALIDUS_CLI_STATS     "--stats"
 
 # define VALIDUS_CLI_NAME "validus"
+# define VALIDUS_CLI_STDIN "-"
 
 # define ANSI_ESC   "\x1b["
 # define ANSI_WHITE ANSI_ESC "97m"
@@ -58,20 +95,106 @@
 # define VALIDUS_CLI_PERF_BLKS    (1024ULL * 1024ULL)
 # define VALIDUS_CLI_PERF_BLKSIZE (1024ULL * 10ULL)
 
+# define VALIDUS_CLI_BATCH_LINES    1024
+# define VALIDUS_CLI_BATCH_READSIZE (4UL * 1024UL * 1024UL)
+# define VALIDUS_CLI_BATCH_OUTSIZE  (1024UL * 1024UL)
+
 # define VALIDUS_CLI_SANITY_INPUTS 8
+
+/* The cross-checks run by -t for each kernel: messages of mixed lengths for
+ * validus_hash_many (enough to fill every lane, with some left over), and a
+ * buffer streamed in chunks of various sizes. */
+# define VALIDUS_CLI_SANITY_MESSAGES 37
+# define VALIDUS_CLI_SANITY_MAXLEN   600
+# define VALIDUS_CLI_SANITY_BUFSIZE  4096
+
+/* the tree mode known answers: an input of three leaves, the last partial. */
+# define VALIDUS_CLI_SANITY_TREESIZE (2 * VALIDUS_TREE_LEAFSIZE + 1000)
+
+/** The size of each part of the file that is grown (VALIDUS_IO_APPEND) in
+ * order to check the fingerprint cache in sanity mode (-t). */
+# define VALIDUS_CLI_SANITY_GROWTH (2 * VALIDUS_RESUME_TAIL + 1000)
 # define VALIDUS_CLI_MAX_ERROR     512
 
+/////////////////////////////// typedefs ///////////////////////////////////////
+
+/** Options which modify the behavior of the selected operation. */
+typedef struct {
+    validus_io_options io; /**< How files are read (VALIDUS_IO_* flags), and the
+                                fingerprint cache, if any. */
+    uint32_t dir_flags;    /**< VALIDUS_DIR_* flags used when walking directories. */
+    size_t jobs;           /**< Number of worker threads; 0 to use one per CPU. */
+    const char* cache;     /**< Path of the fingerprint cache (--cache). */
+    uint64_t cache_slots;  /**< Entries in the fingerprint cache (--cache-slots);
+                                0 for the default, or an existing file's own. */
+    bool no_cache;         /**< Use no fingerprint cache (--no-cache). */
+    uint64_t blocks;       /**< Range size of the signature to output (--blocks);
+                                0 to output a fingerprint. */
+    bool stats;            /**< Print the hot-path counters upon exit. */
+} validus_cli_opts;
+
+/** The result of one file given to ::validus_cli_hash_files. */
+typedef struct {
+    validus_state state;
+    bool ok;
+    bool done; /**< Protected by validus_cli_files::lock. */
+} validus_cli_file;
+
+/**
+ * Files being hashed by ::validus_cli_hash_files. Results are printed in
+ * argument order: whichever worker completes the next file to be printed also
+ * prints every completed file that follows it.
+ */
+typedef struct {
+    char** paths;
+    validus_cli_file* files;
+    size_t count;
+    size_t printed;                  /**< Protected by `lock`. */
+    const validus_cli_opts* opts;
+    validus_mutex lock;
+} validus_cli_files;
+
 /////////////////////////// function exports ///////////////////////////////////
 
 int validus_cli_print_usage(void);
 int validus_cli_print_ver(void);
-int validus_cli_hash_file(const char* file);
+int validus_cli_hash_file(const char* file, const validus_cli_opts* opts);
+int validus_cli_hash_files(char* files[], size_t count, const validus_cli_opts* opts);
+int validus_cli_hash_stdin(const validus_cli_opts* opts);
+int validus_cli_hash_file_tree(const char* file, const validus_cli_opts* opts);
+int validus_cli_hash_ranges(const char* file, const validus_cli_opts* opts);
+int validus_cli_diff_signatures(const char* old_sig, const char* new_sig);
+int validus_cli_hash_dir(const char* dir, const validus_cli_opts* opts);
+int validus_cli_verify_manifest(const char* manifest, const validus_cli_opts* opts);
+int validus_cli_hash_lines(void);
 int validus_cli_hash_string(const char* string);
 int validus_cli_perf_test(void);
+void validus_cli_print_counters(const validus_perf* perf, uint64_t blocks);
 int validus_cli_verify_sanity(void);
 
 //////////////////////////// internal functions ////////////////////////////////
 
+int _validus_cli_operands(const char* mode);
+bool _validus_cli_parse_opts(int* argc, char* argv[], validus_cli_opts* opts);
+bool _validus_cli_check_kernel(const validus_octet* buf);
+bool _validus_cli_check_keyed(const validus_octet* buf);
+bool _validus_cli_check_tree(const validus_octet* buf);
+# if !defined(__WIN__)
+bool _validus_cli_check_cache(const validus_octet* buf);
+# endif
+bool _validus_cli_parse_size(const char* str, uint64_t* size);
+bool _validus_cli_read_signature(validus_signature* sig, const char* path);
+void _validus_cli_print_range(void* ctx, uint64_t offset, uint64_t len);
 void _validus_cli_print_error(const char* format, ...);
+void _validus_cli_hash_files_task(void* ctx, size_t worker, size_t idx);
+void _validus_cli_print_stats(void);
+void _validus_cli_open_cache(validus_cli_opts* opts);
+void _validus_cli_close_cache(void);
+char* _validus_cli_format_fp(char* out, const validus_state* state);
+bool _validus_cli_needs_escape(const char* path);
+void _validus_cli_print_path(const char* path);
+void _validus_cli_print_dir_entry(void* ctx, const char* path, const validus_state* state);
+void _validus_cli_print_verify_failure(void* ctx, const char* path,
+    const validus_state* expected, const validus_state* actual);
 
 #endif /* !_VALIDUS_CLI_H_INCLUDED */
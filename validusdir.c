@@ -0,0 +1,543 @@
+/**
+ * @file validusdir.c
+ * @brief Implementation of recursive directory hashing.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE 1
+#endif
+
+#include "validusio.h"
+#include "validuspool.h"
+
+#if !defined(__WIN__)
+# include <dirent.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/resource.h>
+# include <sys/stat.h>
+# if defined(__linux__)
+#  include <sys/syscall.h>
+# endif
+#endif
+
+#if !defined(__WIN__)
+
+/** The size, in octets, of the buffer that directory entries are read into. */
+# define VALIDUS_DIR_BUFSIZE 65536
+
+typedef enum {
+    VALIDUS_DENT_UNKNOWN = 0,
+    VALIDUS_DENT_FILE,
+    VALIDUS_DENT_DIR,
+    VALIDUS_DENT_LINK,
+    VALIDUS_DENT_OTHER
+} validus_dent_type;
+
+typedef struct {
+    size_t off;       /**< Offset of the name in validus_dents::names. */
+    const char* name; /**< Set once every name has been read. */
+    validus_dent_type type;
+} validus_dent;
+
+/** The entries of one directory. */
+typedef struct {
+    validus_dent* ents;
+    size_t count;
+    size_t cap;
+    char* names;
+    size_t used;
+    size_t size;
+} validus_dents;
+
+# if defined(__linux__) && defined(SYS_getdents64)
+/** The record returned by getdents64(2). */
+typedef struct {
+    uint64_t ino;
+    int64_t off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[];
+} validus_dirent64;
+# endif
+
+/** A file being hashed; the path follows the structure in memory. */
+typedef struct {
+    char* path;
+    int fd;    /**< Opened relative to its directory by the walk. */
+    validus_state state;
+    bool ok;
+    bool done; /**< Protected by validus_dir_walk::lock. */
+} validus_dir_job;
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+} validus_dir_id;
+
+typedef struct {
+    validus_dir_fn fn;
+    void* ctx;
+    uint32_t dir_flags;
+    validus_io_options io;
+    validus_ws_pool* pool;
+    validus_mutex lock;
+    validus_cond cond;                           /**< Signalled as jobs complete. */
+    validus_dir_job* window[VALIDUS_DIR_WINDOW]; /**< In flight, by sequence. */
+    size_t submitted;
+    size_t emitted;
+    size_t limit;                                /**< Files in flight (each holds
+                                                      a descriptor). */
+    char* path;                                  /**< The current directory. */
+    size_t path_len;
+    size_t path_cap;
+    validus_dir_id* ancestors;                   /**< For cycle detection. */
+    size_t depth;
+    size_t depth_cap;
+    char* buf;                                   /**< For getdents64. */
+    dev_t root_dev;
+    bool failed;
+} validus_dir_walk;
+
+static validus_dent_type _validus_dent_type(int type)
+{
+# if defined(DT_UNKNOWN)
+    switch (type) {
+        case DT_REG: return VALIDUS_DENT_FILE;
+        case DT_DIR: return VALIDUS_DENT_DIR;
+        case DT_LNK: return VALIDUS_DENT_LINK;
+        case DT_UNKNOWN: return VALIDUS_DENT_UNKNOWN;
+        default: return VALIDUS_DENT_OTHER;
+    }
+# else
+    (void)type;
+    return VALIDUS_DENT_UNKNOWN;
+# endif
+}
+
+static validus_dent_type _validus_mode_type(mode_t mode)
+{
+    if (S_ISREG(mode))
+        return VALIDUS_DENT_FILE;
+    if (S_ISDIR(mode))
+        return VALIDUS_DENT_DIR;
+    if (S_ISLNK(mode))
+        return VALIDUS_DENT_LINK;
+    return VALIDUS_DENT_OTHER;
+}
+
+static bool _validus_dents_add(validus_dents* dents, const char* name, int type)
+{
+    if ('.' == name[0] && ('\0' == name[1] || ('.' == name[1] && '\0' == name[2])))
+        return true;
+
+    size_t len = strlen(name) + 1;
+
+    if (dents->count == dents->cap) {
+        size_t cap         = dents->cap ? dents->cap * 2 : 64;
+        validus_dent* ents = realloc(dents->ents, cap * sizeof(validus_dent));
+        if (!ents)
+            return false;
+        dents->ents = ents;
+        dents->cap  = cap;
+    }
+
+    if (dents->used + len > dents->size) {
+        size_t size = dents->size ? dents->size * 2 : 4096;
+        while (size < dents->used + len)
+            size *= 2;
+        char* names = realloc(dents->names, size);
+        if (!names)
+            return false;
+        dents->names = names;
+        dents->size  = size;
+    }
+
+    memcpy(dents->names + dents->used, name, len);
+    dents->ents[dents->count].off  = dents->used;
+    dents->ents[dents->count].type = _validus_dent_type(type);
+    dents->count++;
+    dents->used += len;
+
+    return true;
+}
+
+static int _validus_dent_cmp(const void* lhs, const void* rhs)
+{
+    return strcmp(((const validus_dent*)lhs)->name, ((const validus_dent*)rhs)->name);
+}
+
+/** Reads every entry of the directory `fd`, sorted by name. */
+static bool _validus_dir_read(validus_dir_walk* walk, int fd, validus_dents* dents)
+{
+# if defined(__linux__) && defined(SYS_getdents64)
+    for (;;) {
+        long got = syscall(SYS_getdents64, fd, walk->buf, VALIDUS_DIR_BUFSIZE);
+        if (got < 0 && EINTR == errno)
+            continue;
+        if (got < 0)
+            return false;
+        if (0 == got)
+            break;
+
+        for (long off = 0; off < got;) {
+            const validus_dirent64* ent = (const validus_dirent64*)(walk->buf + off);
+            if (!_validus_dents_add(dents, ent->name, ent->type))
+                return false;
+            off += ent->reclen;
+        }
+    }
+# else
+    (void)walk;
+
+    int dupfd = dup(fd);
+    DIR* dir  = dupfd >= 0 ? fdopendir(dupfd) : NULL;
+    if (!dir) {
+        if (dupfd >= 0)
+            (void)close(dupfd);
+        return false;
+    }
+
+    bool ok = true;
+    for (const struct dirent* ent = readdir(dir); ok && ent; ent = readdir(dir)) {
+#  if defined(DT_UNKNOWN)
+        ok = _validus_dents_add(dents, ent->d_name, ent->d_type);
+#  else
+        ok = _validus_dents_add(dents, ent->d_name, 0);
+#  endif
+    }
+    (void)closedir(dir);
+
+    if (!ok)
+        return false;
+# endif
+
+    for (size_t n = 0; n < dents->count; n++)
+        dents->ents[n].name = dents->names + dents->ents[n].off;
+
+    qsort(dents->ents, dents->count, sizeof(validus_dent), &_validus_dent_cmp);
+    return true;
+}
+
+/** Appends "/name" to the current path; returns the length to restore. */
+static size_t _validus_dir_push(validus_dir_walk* walk, const char* name)
+{
+    size_t prev = walk->path_len;
+    size_t len  = strlen(name);
+
+    if (prev + len + 2 > walk->path_cap) {
+        size_t cap = walk->path_cap * 2;
+        while (cap < prev + len + 2)
+            cap *= 2;
+        char* path = realloc(walk->path, cap);
+        if (!path)
+            return SIZE_MAX;
+        walk->path     = path;
+        walk->path_cap = cap;
+    }
+
+    walk->path[prev] = '/';
+    memcpy(walk->path + prev + 1, name, len + 1);
+    walk->path_len = prev + len + 1;
+
+    return prev;
+}
+
+static void _validus_dir_pop(validus_dir_walk* walk, size_t len)
+{
+    walk->path_len  = len;
+    walk->path[len] = '\0';
+}
+
+static void _validus_dir_hash(void* ctx, size_t worker, void* arg)
+{
+    validus_dir_walk* walk = (validus_dir_walk*)ctx;
+    validus_dir_job* job   = (validus_dir_job*)arg;
+    (void)worker;
+
+    job->ok = _validus_hash_file_fd(&job->state, job->fd, job->path, &walk->io);
+    (void)close(job->fd);
+
+    _validus_mutex_lock(&walk->lock);
+    job->done = true;
+    _validus_cond_signal(&walk->cond);
+    _validus_mutex_unlock(&walk->lock);
+}
+
+/**
+ * Reports completed files, in order; blocks until no more than `limit` files
+ * remain in flight.
+ */
+static void _validus_dir_emit(validus_dir_walk* walk, size_t limit)
+{
+    while (walk->emitted < walk->submitted) {
+        validus_dir_job* job = walk->window[walk->emitted % VALIDUS_DIR_WINDOW];
+        bool block           = walk->submitted - walk->emitted > limit;
+
+        _validus_mutex_lock(&walk->lock);
+        while (block && !job->done)
+            _validus_cond_wait(&walk->cond, &walk->lock);
+        bool done = job->done;
+        _validus_mutex_unlock(&walk->lock);
+
+        if (!done)
+            break;
+
+        if (!job->ok)
+            walk->failed = true;
+
+        walk->fn(walk->ctx, job->path, job->ok ? &job->state : NULL);
+        free(job);
+        walk->emitted++;
+    }
+}
+
+/**
+ * Opens the file `name` in the directory `dir` (not following a symbolic link
+ * unless VALIDUS_DIR_FOLLOW is set, so neither it nor its parents can be
+ * swapped for one once read) and queues it to be hashed.
+ */
+static void _validus_dir_submit(validus_dir_walk* walk, int dir, const char* name)
+{
+    _validus_dir_emit(walk, walk->limit);
+
+    validus_dir_job* job = calloc(1, sizeof(validus_dir_job) + walk->path_len + 1);
+    if (!job) {
+        fprintf(stderr, "failed to allocate memory for '%s': %d\n", walk->path, errno);
+        walk->failed = true;
+        return;
+    }
+
+    job->path = (char*)(job + 1);
+    memcpy(job->path, walk->path, walk->path_len + 1);
+
+    walk->window[walk->submitted % VALIDUS_DIR_WINDOW] = job;
+    walk->submitted++;
+
+    /* O_NONBLOCK, so that a FIFO swapped in for the file cannot block. */
+    const bool follow = 0U != (walk->dir_flags & VALIDUS_DIR_FOLLOW);
+    struct stat st;
+
+    job->fd = _validus_file_openat(dir, name, O_NONBLOCK | (follow ? 0 : O_NOFOLLOW),
+        walk->io.flags, job->path);
+    if (job->fd < 0) {
+        job->done = true;
+        return;
+    }
+
+    if (0 != fstat(job->fd, &st) || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "'%s' is not a regular file\n", job->path);
+        (void)close(job->fd);
+        job->done = true;
+        return;
+    }
+
+    (void)fcntl(job->fd, F_SETFL, fcntl(job->fd, F_GETFL) & ~O_NONBLOCK);
+
+    if (!_validus_ws_submit(walk->pool, job))
+        _validus_dir_hash(walk, 0, job);
+}
+
+static void _validus_dir_walk(validus_dir_walk* walk, int fd)
+{
+    validus_dents dents = {0};
+
+    if (!_validus_dir_read(walk, fd, &dents)) {
+        fprintf(stderr, "failed to read directory '%s': %d\n", walk->path, errno);
+        walk->failed = true;
+        goto done;
+    }
+
+    const bool follow = 0U != (walk->dir_flags & VALIDUS_DIR_FOLLOW);
+
+    for (size_t n = 0; n < dents.count; n++) {
+        const validus_dent* ent = &dents.ents[n];
+        validus_dent_type type  = ent->type;
+
+        size_t prev = _validus_dir_push(walk, ent->name);
+        if (SIZE_MAX == prev) {
+            fprintf(stderr, "failed to allocate memory for a path: %d\n", errno);
+            walk->failed = true;
+            break;
+        }
+
+        if (VALIDUS_DENT_UNKNOWN == type || (follow && VALIDUS_DENT_LINK == type)) {
+            struct stat st;
+            int at = follow ? 0 : AT_SYMLINK_NOFOLLOW;
+            if (0 != fstatat(fd, ent->name, &st, at)) {
+                fprintf(stderr, "failed to stat '%s': %d\n", walk->path, errno);
+                walk->failed = true;
+                _validus_dir_pop(walk, prev);
+                continue;
+            }
+            type = _validus_mode_type(st.st_mode);
+        }
+
+        if (VALIDUS_DENT_FILE == type) {
+            _validus_dir_submit(walk, fd, ent->name);
+        } else if (VALIDUS_DENT_DIR == type) {
+            int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (follow ? 0 : O_NOFOLLOW);
+            int subfd = openat(fd, ent->name, flags);
+            struct stat st;
+
+            if (subfd < 0 || 0 != fstat(subfd, &st)) {
+                fprintf(stderr, "failed to open directory '%s': %d\n", walk->path, errno);
+                walk->failed = true;
+            } else if (0U != (walk->dir_flags & VALIDUS_DIR_XDEV) && st.st_dev != walk->root_dev) {
+                /* on another filesystem. */
+            } else {
+                bool cycle = false;
+                for (size_t d = 0; d < walk->depth && !cycle; d++)
+                    cycle = walk->ancestors[d].dev == st.st_dev && walk->ancestors[d].ino == st.st_ino;
+
+                if (cycle) {
+                    fprintf(stderr, "skipping directory cycle at '%s'\n", walk->path);
+                } else if (walk->depth == walk->depth_cap) {
+                    size_t cap          = walk->depth_cap * 2;
+                    validus_dir_id* ids = realloc(walk->ancestors, cap * sizeof(validus_dir_id));
+                    if (ids) {
+                        walk->ancestors = ids;
+                        walk->depth_cap = cap;
+                    } else {
+                        fprintf(stderr, "failed to allocate memory for '%s': %d\n", walk->path, errno);
+                        walk->failed = true;
+                        cycle        = true;
+                    }
+                }
+
+                if (!cycle) {
+                    walk->ancestors[walk->depth].dev = st.st_dev;
+                    walk->ancestors[walk->depth].ino = st.st_ino;
+                    walk->depth++;
+                    _validus_dir_walk(walk, subfd);
+                    walk->depth--;
+                }
+            }
+
+            if (subfd >= 0)
+                (void)close(subfd);
+        }
+
+        _validus_dir_pop(walk, prev);
+    }
+
+done:
+    free(dents.ents);
+    free(dents.names);
+}
+
+#endif /* !__WIN__ */
+
+bool validus_hash_dir(const char* dir, uint32_t dir_flags, const validus_io_options* io,
+    size_t threads, validus_dir_fn fn, void* ctx)
+{
+    if (!dir || !fn)
+        return false;
+
+#if defined(__WIN__)
+    (void)dir_flags;
+    (void)io;
+    (void)threads;
+    (void)ctx;
+    fprintf(stderr, "directory hashing is not supported on this platform\n");
+    return false;
+#else
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    struct stat st;
+
+    if (fd < 0 || 0 != fstat(fd, &st)) {
+        fprintf(stderr, "failed to open directory '%s': %d\n", dir, errno);
+        if (fd >= 0)
+            (void)close(fd);
+        return false;
+    }
+
+    validus_dir_walk* walk = calloc(1, sizeof(validus_dir_walk));
+    if (!walk) {
+        fprintf(stderr, "failed to allocate memory for '%s': %d\n", dir, errno);
+        (void)close(fd);
+        return false;
+    }
+
+    /* "dir/" and "dir" yield the same paths; "/" becomes the empty prefix. */
+    size_t len = strlen(dir);
+    while (len > 0 && '/' == dir[len - 1])
+        len--;
+
+    walk->fn        = fn;
+    walk->ctx       = ctx;
+    walk->dir_flags = dir_flags;
+    walk->io        = io ? *io : (validus_io_options){0};
+    walk->root_dev  = st.st_dev;
+    walk->limit     = VALIDUS_DIR_WINDOW - 1;
+    walk->path_cap  = len + 256;
+    walk->path      = malloc(walk->path_cap);
+    walk->depth_cap = 64;
+    walk->ancestors = calloc(walk->depth_cap, sizeof(validus_dir_id));
+    walk->buf       = malloc(VALIDUS_DIR_BUFSIZE);
+
+    /* leave half of the descriptors for the directories being walked, and
+     * for the caller. */
+    struct rlimit rl;
+    if (0 == getrlimit(RLIMIT_NOFILE, &rl) && RLIM_INFINITY != rl.rlim_cur &&
+        rl.rlim_cur / 2 < walk->limit)
+        walk->limit = rl.rlim_cur > 2 ? (size_t)(rl.rlim_cur / 2) : 1;
+
+    bool ok = false;
+    if (walk->path && walk->ancestors && walk->buf) {
+        memcpy(walk->path, dir, len);
+        walk->path[len] = '\0';
+        walk->path_len  = len;
+
+        walk->ancestors[0].dev = st.st_dev;
+        walk->ancestors[0].ino = st.st_ino;
+        walk->depth            = 1;
+
+        _validus_mutex_init(&walk->lock);
+        _validus_cond_init(&walk->cond);
+
+        /* if no worker can be started, files are hashed on this thread. */
+        walk->pool = _validus_ws_create(threads, &_validus_dir_hash, walk);
+
+        _validus_dir_walk(walk, fd);
+        _validus_dir_emit(walk, 0);
+        _validus_ws_finish(walk->pool);
+
+        _validus_cond_destroy(&walk->cond);
+        _validus_mutex_destroy(&walk->lock);
+
+        ok = !walk->failed;
+    } else {
+        fprintf(stderr, "failed to allocate memory for '%s': %d\n", dir, errno);
+    }
+
+    (void)close(fd);
+    free(walk->buf);
+    free(walk->ancestors);
+    free(walk->path);
+    free(walk);
+
+    return ok;
+#endif
+}
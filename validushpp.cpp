@@ -0,0 +1,85 @@
+/**
+ * @file validushpp.cpp
+ * @brief Checks validus.hpp: the known answers at compile time, and inputs of
+ * every length up to a few blocks against the C library at run time.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validus.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+using validus::fingerprint;
+using validus::fp;
+
+/* the known answers verified by `validus -t`. */
+static_assert(fingerprint("") == fp{0xd3f0ad33U, 0x79790917U, 0x69135e44U,
+    0xeb28aedaU, 0x40e5423dU, 0xd2e956e7U});
+static_assert(fingerprint("abc") == fp{0xf7ffabe5U, 0x4ddb09a9U, 0x3ebde51bU,
+    0x90d1796aU, 0x63ea3cc1U, 0xa5ed093fU});
+static_assert(fingerprint("ABC") == fp{0x9c273091U, 0x9216af67U, 0xc3d9a325U,
+    0x4401ade8U, 0x5920b7c1U, 0xd707c65dU});
+static_assert(fingerprint("validus") == fp{0xa16bbad7U, 0x293dac29U, 0x04cc1807U,
+    0x6636125cU, 0x2c68c29cU, 0xcffa779dU});
+static_assert(fingerprint("1111111") == fp{0x4f7879dfU, 0xe986f48eU, 0x047190feU,
+    0x0961783aU, 0x177b6dc1U, 0x9d5f30d1U});
+static_assert(fingerprint("1111112") == fp{0x5f26b88dU, 0xd4c24f7dU, 0xe828d3edU,
+    0x18dc0a05U, 0x45f26eb0U, 0xc0b09061U});
+static_assert(fingerprint("hello, world") == fp{0xa54b0badU, 0xf8061b9bU, 0x6f14c542U,
+    0x0d2bd823U, 0x9fbb7f67U, 0x50b67af7U});
+static_assert(fingerprint("dlrow ,olleh") == fp{0x3a39f172U, 0xc900b9d8U, 0x6efe31ddU,
+    0xc065bdf9U, 0xe02c4837U, 0x50f9af86U});
+
+/* usable where only constants are. */
+static_assert(fingerprint("abc").key() == 0xf7ffabe54ddb09a9ULL);
+
+/** The largest input checked against the C library. */
+constexpr std::size_t max_len = 4 * VALIDUS_FP_SIZE_B + 1;
+
+} // namespace
+
+int main()
+{
+    std::string input;
+    bool pass = true;
+
+    for (std::size_t len = 0; len <= max_len; len++) {
+        validus_state expected = {};
+        validus_init(&expected);
+        validus_append(&expected, input.data(), input.size());
+        validus_finalize(&expected);
+
+        validus_state actual = fingerprint(input).state();
+        if (!validus_compare(&expected, &actual)) {
+            std::fprintf(stderr, "validus.hpp: mismatch at %zu octets\n", len);
+            pass = false;
+        }
+
+        input.push_back(static_cast<char>((len * 131U + 7U) & 0xffU));
+    }
+
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
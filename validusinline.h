@@ -0,0 +1,70 @@
+/**
+ * @file validusinline.h
+ * @brief Single-header build of Validus.
+ *
+ * Include this header instead of validus.h and validusutil.h, and define
+ * VALIDUS_IMPLEMENTATION before including it in exactly one translation unit
+ * (where it should be the first include). The core functions, and the one-shot
+ * ::validus_hash_mem and ::validus_hash_string, are then `static inline` in
+ * every translation unit, so the compiler can inline them and fold constant
+ * lengths at their call sites; everything else (kernel selection, I/O, thread
+ * pools) is compiled once, into the translation unit that defines
+ * VALIDUS_IMPLEMENTATION.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _VALIDUS_INLINE_H_INCLUDED
+# define _VALIDUS_INLINE_H_INCLUDED
+
+# if defined(VALIDUS_IMPLEMENTATION) && defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE 1
+# endif
+
+# if !defined(_DEFAULT_SOURCE)
+#  define _DEFAULT_SOURCE 1
+# endif
+
+# if !defined(VALIDUS_HEADER_ONLY)
+#  define VALIDUS_HEADER_ONLY
+# endif
+
+# include "validusutil.h"
+# include "validus.c"
+
+# if defined(VALIDUS_IMPLEMENTATION)
+#  include "validuskernel.c"
+#  include "validusmb.c"
+#  include "validusutil.c"
+#  include "validusio.c"
+#  include "validusasync.c"
+#  include "validuspool.c"
+#  include "validustree.c"
+#  include "validusranges.c"
+#  include "validuskeyed.c"
+#  include "validusdir.c"
+#  include "validusverify.c"
+#  include "validusstats.c"
+#  include "validuscache.c"
+# endif
+
+#endif /* !_VALIDUS_INLINE_H_INCLUDED */
@@ -0,0 +1,565 @@
+/**
+ * @file validusio.c
+ * @brief Implementation of the internal file I/O helpers.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE 1
+#endif
+
+#include "validusio.h"
+
+#if !defined(__WIN__)
+# include <fcntl.h>
+# include <unistd.h>
+# include <pthread.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+/** The size, in octets, that huge page-backed buffers are rounded up to. */
+#define VALIDUS_HUGEBUF_ALIGN (2UL * 1024UL * 1024UL)
+
+/** A thread's read buffer (see ::_validus_io_buffer). */
+typedef struct {
+    void* ptr;
+    size_t len;
+    bool mapped; /**< Allocated by mmap, rather than ::_validus_alloc_aligned. */
+    bool huge;   /**< Allocated on huge pages (VALIDUS_IO_HUGEBUF). */
+    bool nohuge; /**< VALIDUS_IO_HUGEBUF was requested, but huge pages could
+                      not be allocated; not retried for a buffer this size. */
+} validus_io_tls;
+
+static _Thread_local validus_io_tls* _validus_io_self = NULL;
+
+#if defined(__WIN__)
+static INIT_ONCE _validus_io_once = INIT_ONCE_STATIC_INIT;
+static DWORD _validus_io_key      = FLS_OUT_OF_INDEXES;
+#else
+static pthread_once_t _validus_io_once = PTHREAD_ONCE_INIT;
+static pthread_key_t _validus_io_key;
+static bool _validus_io_have_key       = false;
+#endif
+
+validus_fd _validus_file_open(const char* file, uint32_t flags)
+{
+#if defined(__WIN__)
+    DWORD attrs   = (flags & VALIDUS_IO_DIRECT) ? FILE_FLAG_NO_BUFFERING : FILE_ATTRIBUTE_NORMAL;
+    validus_fd fd = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL, OPEN_EXISTING, attrs, NULL);
+    if (VALIDUS_INVALID_FD == fd && (flags & VALIDUS_IO_DIRECT))
+        fd = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (VALIDUS_INVALID_FD == fd)
+        fprintf(stderr, "failed to open file '%s': %lu\n", file, GetLastError());
+#else
+    validus_fd fd = _validus_file_openat(AT_FDCWD, file, 0, flags, file);
+#endif
+    return fd;
+}
+
+#if !defined(__WIN__)
+validus_fd _validus_file_openat(int dir, const char* name, int oflags, uint32_t flags,
+    const char* path)
+{
+    validus_fd fd = VALIDUS_INVALID_FD;
+    oflags       |= O_RDONLY | O_CLOEXEC;
+# if defined(O_DIRECT)
+    /* filesystems without direct I/O (tmpfs, for one) refuse it with EINVAL. */
+    if (flags & VALIDUS_IO_DIRECT)
+        fd = openat(dir, name, oflags | O_DIRECT);
+    if (VALIDUS_INVALID_FD == fd)
+        fd = openat(dir, name, oflags);
+# else
+    fd = openat(dir, name, oflags);
+#  if defined(F_NOCACHE)
+    if (VALIDUS_INVALID_FD != fd && (flags & VALIDUS_IO_DIRECT))
+        (void)fcntl(fd, F_NOCACHE, 1);
+#  endif
+# endif
+    if (VALIDUS_INVALID_FD == fd)
+        fprintf(stderr, "failed to open file '%s': %d\n", path, errno);
+    return fd;
+}
+#endif
+
+void _validus_file_close(validus_fd fd)
+{
+#if defined(__WIN__)
+    (void)CloseHandle(fd);
+#else
+    (void)close(fd);
+#endif
+}
+
+bool _validus_file_stat(validus_fd fd, uint64_t* size, bool* regular)
+{
+#if defined(__WIN__)
+    if (FILE_TYPE_DISK != GetFileType(fd)) {
+        if (size)
+            *size = 0;
+        if (regular)
+            *regular = false;
+        return true;
+    }
+
+    LARGE_INTEGER li;
+    if (!GetFileSizeEx(fd, &li)) {
+        fprintf(stderr, "GetFileSizeEx() failed: %lu\n", GetLastError());
+        return false;
+    }
+    if (size)
+        *size = (uint64_t)li.QuadPart;
+    if (regular)
+        *regular = FILE_TYPE_DISK == GetFileType(fd);
+#else
+    struct stat st;
+    if (0 != fstat(fd, &st)) {
+        fprintf(stderr, "fstat() failed: %d\n", errno);
+        return false;
+    }
+    if (size)
+        *size = (uint64_t)st.st_size;
+    if (regular)
+        *regular = S_ISREG(st.st_mode);
+#endif
+    return true;
+}
+
+bool _validus_file_id(validus_fd fd, validus_file_id* id)
+{
+#if defined(__WIN__)
+    (void)fd;
+    (void)id;
+    return false;
+#else
+    struct stat st;
+    if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode))
+        return false;
+
+    id->dev  = (uint64_t)st.st_dev;
+    id->ino  = (uint64_t)st.st_ino;
+    id->size = (uint64_t)st.st_size;
+# if defined(__APPLE__)
+    id->mtime_ns = (int64_t)st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+    id->ctime_ns = (int64_t)st.st_ctimespec.tv_sec * 1000000000LL + st.st_ctimespec.tv_nsec;
+# else
+    id->mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    id->ctime_ns = (int64_t)st.st_ctim.tv_sec * 1000000000LL + st.st_ctim.tv_nsec;
+# endif
+    return true;
+#endif
+}
+
+bool _validus_file_read(validus_fd fd, void* buf, size_t len, size_t* got)
+{
+#if defined(__WIN__)
+    DWORD want  = len > 0x40000000UL ? 0x40000000UL : (DWORD)len;
+    DWORD count = 0;
+    if (!ReadFile(fd, buf, want, &count, NULL)) {
+        if (ERROR_BROKEN_PIPE != GetLastError()) {
+            fprintf(stderr, "ReadFile() failed: %lu\n", GetLastError());
+            return false;
+        }
+        count = 0;
+    }
+#else
+    ssize_t count;
+    do {
+        count = read(fd, buf, len);
+    } while (count < 0 && EINTR == errno);
+
+    if (count < 0) {
+        fprintf(stderr, "read() failed: %d\n", errno);
+        return false;
+    }
+#endif
+
+    *got = (size_t)count;
+    return true;
+}
+
+bool _validus_file_pread(validus_fd fd, void* buf, size_t len, uint64_t off,
+    size_t* got)
+{
+    size_t done = 0;
+
+    while (done < len) {
+#if defined(__WIN__)
+        OVERLAPPED ov = {0};
+        ov.Offset     = (DWORD)(off + done);
+        ov.OffsetHigh = (DWORD)((off + done) >> 32);
+        DWORD want = (len - done) > 0x40000000UL ? 0x40000000UL : (DWORD)(len - done);
+        DWORD read = 0;
+        if (!ReadFile(fd, (validus_octet*)buf + done, want, &read, &ov)) {
+            if (ERROR_HANDLE_EOF == GetLastError())
+                break;
+            fprintf(stderr, "ReadFile() failed: %lu\n", GetLastError());
+            return false;
+        }
+#else
+        ssize_t read = pread(fd, (validus_octet*)buf + done, len - done,
+            (off_t)(off + done));
+        if (read < 0) {
+            if (EINTR == errno)
+                continue;
+            fprintf(stderr, "pread() failed: %d\n", errno);
+            return false;
+        }
+#endif
+        if (0 == read)
+            break;
+        done += (size_t)read;
+    }
+
+    *got = done;
+    return true;
+}
+
+bool _validus_file_tell(validus_fd fd, uint64_t* pos)
+{
+#if defined(__WIN__)
+    LARGE_INTEGER zero = {0}, at = {0};
+    if (!SetFilePointerEx(fd, zero, &at, FILE_CURRENT))
+        return false;
+    *pos = (uint64_t)at.QuadPart;
+#else
+    off_t at = lseek(fd, 0, SEEK_CUR);
+    if (at < 0)
+        return false;
+    *pos = (uint64_t)at;
+#endif
+    return true;
+}
+
+bool _validus_file_seek(validus_fd fd, uint64_t pos)
+{
+#if defined(__WIN__)
+    LARGE_INTEGER to = {0};
+    to.QuadPart      = (LONGLONG)pos;
+    return FALSE != SetFilePointerEx(fd, to, NULL, FILE_BEGIN);
+#else
+    return lseek(fd, (off_t)pos, SEEK_SET) >= 0;
+#endif
+}
+
+bool _validus_file_extent(validus_fd fd, uint64_t off, uint64_t size, uint64_t* data,
+    uint64_t* hole)
+{
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    /* seeking moves the file pointer, which others may yet read from. */
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos < 0)
+        return false;
+
+    bool ok    = true;
+    off_t next = lseek(fd, (off_t)off, SEEK_DATA);
+
+    if (next < 0) {
+        /* ENXIO: nothing but a hole from `off` to the end of the file. */
+        ok    = ENXIO == errno;
+        *data = *hole = size;
+    } else {
+        *data = (uint64_t)next < size ? (uint64_t)next : size;
+
+        next = lseek(fd, (off_t)*data, SEEK_HOLE);
+        if (next < 0) {
+            ok   = ENXIO == errno;
+            next = (off_t)size;
+        }
+
+        *hole = (uint64_t)next < size ? (uint64_t)next : size;
+    }
+
+    (void)lseek(fd, pos, SEEK_SET);
+    return ok;
+#else
+    (void)fd;
+    (void)off;
+    (void)size;
+    (void)data;
+    (void)hole;
+    return false;
+#endif
+}
+
+const void* _validus_file_map(validus_fd fd, uint64_t off, size_t len, uint32_t flags)
+{
+#if defined(__WIN__)
+    (void)fd;
+    (void)off;
+    (void)len;
+    (void)flags;
+    return NULL;
+#else
+    if (len == 0)
+        return NULL;
+
+    int mflags = MAP_PRIVATE;
+# if defined(MAP_POPULATE)
+    if (flags & VALIDUS_IO_POPULATE)
+        mflags |= MAP_POPULATE;
+# endif
+
+    void* addr = mmap(NULL, len, PROT_READ, mflags, fd, (off_t)off);
+    if (MAP_FAILED == addr)
+        return NULL;
+
+    /* advice is only a hint; failures are of no consequence. */
+    (void)posix_madvise(addr, len, POSIX_MADV_SEQUENTIAL);
+    (void)posix_madvise(addr, len, POSIX_MADV_WILLNEED);
+# if defined(MADV_HUGEPAGE)
+    if (flags & VALIDUS_IO_HUGEPAGES)
+        (void)madvise(addr, len, MADV_HUGEPAGE);
+# endif
+
+    return addr;
+#endif
+}
+
+void _validus_file_unmap(const void* addr, size_t len)
+{
+#if defined(__WIN__)
+    (void)addr;
+    (void)len;
+#else
+    if (addr)
+        (void)munmap((void*)addr, len);
+#endif
+}
+
+void _validus_file_advise(validus_fd fd, uint32_t flags)
+{
+#if defined(POSIX_FADV_SEQUENTIAL)
+    /* advice is only a hint; failures (e.g. ESPIPE) are of no consequence. */
+    if (flags & VALIDUS_IO_SEQUENTIAL)
+        (void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (flags & VALIDUS_IO_NOCACHE)
+        (void)posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE);
+#else
+    (void)fd;
+    (void)flags;
+#endif
+}
+
+void _validus_file_drop(validus_fd fd, uint64_t off, uint64_t len)
+{
+#if defined(POSIX_FADV_DONTNEED)
+    (void)posix_fadvise(fd, (off_t)off, (off_t)len, POSIX_FADV_DONTNEED);
+#else
+    (void)fd;
+    (void)off;
+    (void)len;
+#endif
+}
+
+void _validus_pipe_grow(validus_fd fd)
+{
+#if defined(F_SETPIPE_SZ)
+    /* unprivileged processes are capped at fs.pipe-max-size (1 MiB by default). */
+    for (int size = VALIDUS_PIPE_SIZE; size > 65536; size /= 2) {
+        if (fcntl(fd, F_SETPIPE_SZ, size) >= 0 || EBADF == errno)
+            break;
+    }
+#else
+    (void)fd;
+#endif
+}
+
+validus_fd _validus_stdin(void)
+{
+#if defined(__WIN__)
+    return GetStdHandle(STD_INPUT_HANDLE);
+#else
+    return STDIN_FILENO;
+#endif
+}
+
+void* _validus_alloc_aligned(size_t len)
+{
+#if defined(__WIN__)
+    return _aligned_malloc(len, VALIDUS_IO_ALIGN);
+#else
+    void* ptr = NULL;
+    return 0 == posix_memalign(&ptr, VALIDUS_IO_ALIGN, len) ? ptr : NULL;
+#endif
+}
+
+void _validus_free_aligned(void* ptr)
+{
+#if defined(__WIN__)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+static void _validus_io_free(validus_io_tls* self)
+{
+    if (self->mapped) {
+#if !defined(__WIN__)
+        (void)munmap(self->ptr, self->len);
+#endif
+    } else {
+        _validus_free_aligned(self->ptr);
+    }
+
+    self->ptr    = NULL;
+    self->len    = 0;
+    self->mapped = false;
+    self->huge   = false;
+    self->nohuge = false;
+}
+
+/** Frees an exiting thread's read buffer. */
+#if defined(__WIN__)
+static void WINAPI _validus_io_retire(void* arg)
+#else
+static void _validus_io_retire(void* arg)
+#endif
+{
+    validus_io_tls* self = (validus_io_tls*)arg;
+    if (!self)
+        return;
+
+    /* destructors run on the exiting thread, in no particular order: a later
+     * one that reads a file allocates a new buffer. */
+    if (_validus_io_self == self)
+        _validus_io_self = NULL;
+
+    _validus_io_free(self);
+    free(self);
+}
+
+#if defined(__WIN__)
+static BOOL CALLBACK _validus_io_init(PINIT_ONCE once, PVOID param, PVOID* ctx)
+{
+    (void)once;
+    (void)param;
+    (void)ctx;
+    _validus_io_key = FlsAlloc(&_validus_io_retire);
+    return TRUE;
+}
+#else
+static void _validus_io_init(void)
+{
+    _validus_io_have_key = 0 == pthread_key_create(&_validus_io_key, &_validus_io_retire);
+}
+#endif
+
+/** Allocates `len` octets on huge pages: explicit ones if any are reserved,
+ * transparent ones otherwise. */
+static void* _validus_io_alloc_huge(size_t len)
+{
+#if defined(__WIN__)
+    (void)len;
+    return NULL;
+#else
+    void* ptr = MAP_FAILED;
+# if defined(MAP_HUGETLB)
+    ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+        -1, 0);
+# endif
+    if (MAP_FAILED == ptr) {
+        ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == ptr)
+            return NULL;
+# if defined(MADV_HUGEPAGE)
+        (void)madvise(ptr, len, MADV_HUGEPAGE);
+# endif
+    }
+    return ptr;
+#endif
+}
+
+void* _validus_io_buffer(size_t len, uint32_t flags)
+{
+    validus_io_tls* self = _validus_io_self;
+    bool huge            = 0U != (flags & VALIDUS_IO_HUGEBUF);
+
+    if (self && self->ptr && self->len >= len && (self->huge || self->nohuge || !huge))
+        return self->ptr;
+
+    if (!self) {
+        self = calloc(1, sizeof(validus_io_tls));
+        if (!self) {
+            fprintf(stderr, "failed to allocate memory: %d\n", errno);
+            return NULL;
+        }
+
+        /* without a destructor, the buffer is kept (and leaked) after exit. */
+#if defined(__WIN__)
+        (void)InitOnceExecuteOnce(&_validus_io_once, &_validus_io_init, NULL, NULL);
+        if (FLS_OUT_OF_INDEXES != _validus_io_key)
+            (void)FlsSetValue(_validus_io_key, self);
+#else
+        (void)pthread_once(&_validus_io_once, &_validus_io_init);
+        if (_validus_io_have_key)
+            (void)pthread_setspecific(_validus_io_key, self);
+#endif
+        _validus_io_self = self;
+    }
+
+    _validus_io_free(self);
+
+    if (huge) {
+        size_t size = (len + VALIDUS_HUGEBUF_ALIGN - 1) & ~(VALIDUS_HUGEBUF_ALIGN - 1);
+        self->ptr   = _validus_io_alloc_huge(size);
+        if (self->ptr)
+            len = size;
+        self->mapped = NULL != self->ptr;
+    }
+
+    if (!self->ptr)
+        self->ptr = _validus_alloc_aligned(len);
+
+    if (!self->ptr) {
+        fprintf(stderr, "failed to allocate %zu octets of heap memory: %d\n", len, errno);
+        return NULL;
+    }
+
+    self->len    = len;
+    self->huge   = self->mapped;
+    self->nohuge = huge && !self->mapped;
+
+    return self->ptr;
+}
+
+void validus_io_release(void)
+{
+    validus_io_tls* self = _validus_io_self;
+    if (!self)
+        return;
+
+#if defined(__WIN__)
+    if (FLS_OUT_OF_INDEXES != _validus_io_key)
+        (void)FlsSetValue(_validus_io_key, NULL);
+#else
+    if (_validus_io_have_key)
+        (void)pthread_setspecific(_validus_io_key, NULL);
+#endif
+
+    _validus_io_retire(self);
+    _validus_io_self = NULL;
+}
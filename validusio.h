@@ -0,0 +1,296 @@
+/**
+ * @file validusio.h
+ * @brief Internal file I/O helpers used by the Validus utility functions.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _VALIDUS_IO_H_INCLUDED
+# define _VALIDUS_IO_H_INCLUDED
+
+# include "validusutil.h"
+
+/////////////////////////////// typedefs ///////////////////////////////////////
+
+# if defined(__WIN__)
+typedef HANDLE validus_fd;                     /**< An open file. */
+#  define VALIDUS_INVALID_FD INVALID_HANDLE_VALUE
+# else
+typedef int validus_fd;                        /**< An open file. */
+#  define VALIDUS_INVALID_FD (-1)
+# endif
+
+/** The identity and version of a regular file, as cached by ::validus_cache. */
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtime_ns;
+    int64_t ctime_ns;
+} validus_file_id;
+
+/**
+ * The state of a cached file's hash before finalization (VALIDUS_IO_APPEND),
+ * from which it can be resumed once the file has grown.
+ */
+typedef struct {
+    uint64_t size;       /**< The size of the file when it was recorded. */
+    uint64_t offset;     /**< The octets hashed into `state`: a whole number of
+                              blocks, no more than `size`. */
+    validus_state state; /**< The state after `offset` octets (`bits` unset). */
+    uint64_t tail;       /**< A check of the file's last VALIDUS_RESUME_TAIL
+                              (or more) octets, up to `size`. */
+} validus_cache_mid;
+
+/** The size, in octets, of a serialized fingerprint (f0..f5). */
+# define VALIDUS_FP_OCTETS (6 * sizeof(validus_word))
+
+///////////////////////////// inline helpers ///////////////////////////////////
+
+/** Stores a word in 4 octets, little-endian. */
+static inline void _validus_store32(validus_octet* out, validus_word w)
+{
+    out[0] = (validus_octet)(w);
+    out[1] = (validus_octet)(w >> 8);
+    out[2] = (validus_octet)(w >> 16);
+    out[3] = (validus_octet)(w >> 24);
+}
+
+/** Loads a word stored by ::_validus_store32. */
+static inline validus_word _validus_load32(const validus_octet* in)
+{
+    return (validus_word)in[0] | ((validus_word)in[1] << 8) |
+        ((validus_word)in[2] << 16) | ((validus_word)in[3] << 24);
+}
+
+/** Stores a 64-bit value in 8 octets, little-endian. */
+static inline void _validus_store64(validus_octet* out, uint64_t v)
+{
+    _validus_store32(out,     (validus_word)v);
+    _validus_store32(out + 4, (validus_word)(v >> 32));
+}
+
+/** Loads a value stored by ::_validus_store64. */
+static inline uint64_t _validus_load64(const validus_octet* in)
+{
+    return (uint64_t)_validus_load32(in) | ((uint64_t)_validus_load32(in + 4) << 32);
+}
+
+/** Stores the fingerprint (f0..f5) of `state` in VALIDUS_FP_OCTETS octets. */
+static inline void _validus_fp_store(validus_octet* out, const validus_state* state)
+{
+    _validus_store32(out,      state->f0);
+    _validus_store32(out + 4,  state->f1);
+    _validus_store32(out + 8,  state->f2);
+    _validus_store32(out + 12, state->f3);
+    _validus_store32(out + 16, state->f4);
+    _validus_store32(out + 20, state->f5);
+}
+
+/** Loads a fingerprint stored by ::_validus_fp_store into `state`. */
+static inline void _validus_fp_load(validus_state* state, const validus_octet* in)
+{
+    state->f0 = _validus_load32(in);
+    state->f1 = _validus_load32(in + 4);
+    state->f2 = _validus_load32(in + 8);
+    state->f3 = _validus_load32(in + 12);
+    state->f4 = _validus_load32(in + 16);
+    state->f5 = _validus_load32(in + 20);
+}
+
+///////////////////////////// function exports /////////////////////////////////
+
+# if defined(__cplusplus)
+extern "C" {
+# endif
+
+/**
+ * Opens `file` for reading. With VALIDUS_IO_DIRECT in `flags`, the page cache
+ * is bypassed if the filesystem allows it. Returns VALIDUS_INVALID_FD (having
+ * reported the error on stderr) upon failure.
+ */
+validus_fd _validus_file_open(const char* file, uint32_t flags);
+
+# if !defined(__WIN__)
+/**
+ * As ::_validus_file_open, but opens `name` relative to the directory `dir`
+ * (or AT_FDCWD), adding the open(2) flags `oflags` (e.g. O_NOFOLLOW). `path`
+ * names the file in error messages.
+ */
+validus_fd _validus_file_openat(int dir, const char* name, int oflags, uint32_t flags,
+    const char* path);
+# endif
+
+/** Closes a file opened by ::_validus_file_open. */
+void _validus_file_close(validus_fd fd);
+
+/**
+ * Retrieves the size of an open file, in octets, and whether it is a regular
+ * file (as opposed to a pipe, socket, character device, etc.). Either output
+ * may be NULL.
+ */
+bool _validus_file_stat(validus_fd fd, uint64_t* size, bool* regular);
+
+/**
+ * Retrieves the identity of an open regular file. Returns false if it is not a
+ * regular file, or the platform does not provide one.
+ */
+bool _validus_file_id(validus_fd fd, validus_file_id* id);
+
+/**
+ * Reads up to `len` octets at the current file position. `got` receives the
+ * number of octets read, which is zero only at end of file.
+ */
+bool _validus_file_read(validus_fd fd, void* buf, size_t len, size_t* got);
+
+/**
+ * Reads up to `len` octets at offset `off`, without moving the file pointer.
+ * Fewer than `len` octets are read only at end of file. `got` receives the
+ * number of octets read.
+ */
+bool _validus_file_pread(validus_fd fd, void* buf, size_t len, uint64_t off,
+    size_t* got);
+
+/** Retrieves the file pointer of a regular file. */
+bool _validus_file_tell(validus_fd fd, uint64_t* pos);
+
+/** Moves the file pointer of a regular file to `pos`. */
+bool _validus_file_seek(validus_fd fd, uint64_t pos);
+
+/**
+ * Finds the next extent of data in a regular file of `size` octets: `data`
+ * receives the offset of the first octet of data at or after `off`, and `hole`
+ * the offset of the hole that follows it (both are `size` if there is no more
+ * data). Returns false if holes cannot be reported (by the platform, or upon
+ * error).
+ */
+bool _validus_file_extent(validus_fd fd, uint64_t off, uint64_t size, uint64_t* data,
+    uint64_t* hole);
+
+/**
+ * Maps `len` octets of a regular file, starting at `off` (a multiple of the
+ * page size), for sequential reading. `flags` are VALIDUS_IO_* flags; hints the
+ * platform does not support are ignored. Returns NULL if the file could not be
+ * mapped, in which case the caller is expected to fall back to reading it.
+ */
+const void* _validus_file_map(validus_fd fd, uint64_t off, size_t len, uint32_t flags);
+
+/** Unmaps a mapping created by ::_validus_file_map. */
+void _validus_file_unmap(const void* addr, size_t len);
+
+/**
+ * Gives the access pattern advice requested by VALIDUS_IO_SEQUENTIAL and
+ * VALIDUS_IO_NOCACHE in `flags` for a regular file; a no-op elsewhere.
+ */
+void _validus_file_advise(validus_fd fd, uint32_t flags);
+
+/** Drops `len` octets at `off` from the page cache (VALIDUS_IO_NOCACHE); zero
+ * `len` means to the end of the file. */
+void _validus_file_drop(validus_fd fd, uint64_t off, uint64_t len);
+
+/**
+ * Hashes the remainder of `fd` into `stream` through a pipeline that keeps
+ * VALIDUS_ASYNC_DEPTH reads in flight: io_uring for regular files where the
+ * kernel supports it, a reader thread otherwise. `failed` is set if a read
+ * fails. Returns false, without consuming any input, if the pipeline could not
+ * be started.
+ */
+bool _validus_hash_async(validus_stream* stream, validus_fd fd, bool* failed);
+
+/**
+ * Hashes everything that can be read from `fd` (a file, pipe or FIFO, such as
+ * stdin), as ::validus_hash_file_opts does. `name` is used in error messages;
+ * `opts` may be NULL.
+ */
+bool _validus_hash_fd(validus_state* state, validus_fd fd, const char* name,
+    const validus_io_options* opts);
+
+/**
+ * Hashes the regular file open as `fd`, as ::validus_hash_file_opts does once
+ * it has opened it: with a cache in `opts`, an unchanged file's fingerprint is
+ * reused, and an appended one is resumed. `fd` is left open.
+ */
+bool _validus_hash_file_fd(validus_state* state, validus_fd fd, const char* name,
+    const validus_io_options* opts);
+
+/** As ::_validus_hash_fd, but writes into `stream` and leaves it unfinalized. */
+bool _validus_hash_stream(validus_stream* stream, validus_fd fd, const char* name,
+    const validus_io_options* opts);
+
+
+/**
+ * Fingerprints each range of `range_size` octets of `fd`, a regular file of
+ * `size` octets, into `out` (which has ::validus_range_count entries), on
+ * `threads` workers. See ::validus_hash_ranges.
+ */
+bool _validus_hash_ranges(validus_fd fd, uint64_t size, uint64_t range_size,
+    size_t threads, validus_state* out);
+
+/** Asks for the pipe `fd` to be enlarged to VALIDUS_PIPE_SIZE; a no-op if it
+ * is not a pipe, or the platform has no such control. */
+void _validus_pipe_grow(validus_fd fd);
+
+/**
+ * Looks up the file `id` in `cache`. Returns true, with its fingerprint in
+ * `state`, if there is an entry for it that is intact and current.
+ */
+bool _validus_cache_get(validus_cache* cache, const validus_file_id* id, validus_state* state);
+
+/**
+ * Looks up the file `id` in `cache`. Returns true, with its recorded state
+ * before finalization in `mid`, if there is an intact entry for it that has
+ * one, and the file has grown since.
+ */
+bool _validus_cache_get_mid(validus_cache* cache, const validus_file_id* id,
+    validus_cache_mid* mid);
+
+/**
+ * Records the fingerprint of the file `id` in `cache`, along with `mid` (if
+ * not NULL), unless it changed too recently (VALIDUS_CACHE_SETTLE_NS) to be
+ * trusted. Such an entry is still recorded if it has a `mid`, but only for
+ * ::_validus_cache_get_mid.
+ */
+void _validus_cache_put(validus_cache* cache, const validus_file_id* id,
+    const validus_state* state, const validus_cache_mid* mid);
+
+/** Returns the standard input. */
+validus_fd _validus_stdin(void);
+
+/** Allocates `len` octets, aligned to VALIDUS_IO_ALIGN. */
+void* _validus_alloc_aligned(size_t len);
+
+void _validus_free_aligned(void* ptr);
+
+/**
+ * Returns the calling thread's read buffer, (re)allocated if it is smaller than
+ * `len` octets, or if VALIDUS_IO_HUGEBUF is in `flags` and it is not backed by
+ * huge pages. The buffer is aligned to VALIDUS_IO_ALIGN, and is kept until
+ * the thread exits or calls ::validus_io_release. Returns NULL (having
+ * reported the error on stderr) if it could not be allocated.
+ */
+void* _validus_io_buffer(size_t len, uint32_t flags);
+
+# if defined(__cplusplus)
+}
+# endif
+
+#endif /* !_VALIDUS_IO_H_INCLUDED */
@@ -0,0 +1,233 @@
+/**
+ * @file validuskernel.c
+ * @brief Run-time selection of the Validus compression kernels.
+ *
+ * Detects the features of the host CPU, and selects the best kernel once, at
+ * load time (or upon first use, where load-time initializers are unavailable).
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validuskernel.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(VALIDUS_X86)
+# if defined(_MSC_VER)
+#  include <intrin.h>
+# else
+#  include <cpuid.h>
+# endif
+#endif
+
+/** The compact kernel: the rounds as a loop over a table, for a small code footprint. */
+#define VALIDUS_KERNEL_COMPACT \
+    {"compact", 0U, &_validus_process_compact, &_validus_finalize_compact, NULL, 0}
+
+/** The kernel table, ordered from most to least preferred. */
+static const validus_kernel _validus_kernels[] = {
+#if defined(VALIDUS_COMPACT_KERNEL)
+    VALIDUS_KERNEL_COMPACT,
+#endif
+#if defined(VALIDUS_X86)
+    {"avx512", VALIDUS_CPU_AVX512F | VALIDUS_CPU_AVX2 | VALIDUS_CPU_BMI2 | VALIDUS_CPU_SSE41,
+        &_validus_process_bmi2, &_validus_finalize_bmi2,
+        &_validus_lanes_avx512, 16},
+    {"avx2", VALIDUS_CPU_AVX2 | VALIDUS_CPU_BMI2 | VALIDUS_CPU_SSE41,
+        &_validus_process_bmi2, &_validus_finalize_bmi2,
+        &_validus_lanes_avx2, 8},
+    {"bmi2", VALIDUS_CPU_BMI2 | VALIDUS_CPU_SSE41,
+        &_validus_process_bmi2, &_validus_finalize_bmi2,
+        &_validus_lanes_sse41, 4},
+    {"sse41", VALIDUS_CPU_SSE41,
+        &_validus_process_generic, &_validus_finalize_generic,
+        &_validus_lanes_sse41, 4},
+#endif
+    {"generic", 0U, &_validus_process_generic, &_validus_finalize_generic, NULL, 0},
+#if !defined(VALIDUS_COMPACT_KERNEL)
+    VALIDUS_KERNEL_COMPACT
+#endif
+};
+
+#define VALIDUS_KERNEL_COUNT (sizeof(_validus_kernels) / sizeof(_validus_kernels[0]))
+
+static const validus_kernel* _validus_active_kernel = NULL;
+
+#if defined(VALIDUS_X86)
+static void _validus_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+# if defined(_MSC_VER)
+    int tmp[4] = {0};
+    __cpuidex(tmp, (int)leaf, (int)subleaf);
+    for (size_t n = 0; n < 4; n++)
+        regs[n] = (uint32_t)tmp[n];
+# else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    if (!__get_cpuid_count(leaf, subleaf, &a, &b, &c, &d))
+        a = b = c = d = 0;
+    regs[0] = a;
+    regs[1] = b;
+    regs[2] = c;
+    regs[3] = d;
+# endif
+}
+
+static uint64_t _validus_xgetbv(void)
+{
+# if defined(_MSC_VER)
+    return (uint64_t)_xgetbv(0);
+# else
+    uint32_t lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+# endif
+}
+#endif
+
+static uint32_t _validus_cpu_features(void)
+{
+    uint32_t features = 0U;
+
+#if defined(VALIDUS_X86)
+    uint32_t regs[4] = {0};
+
+    _validus_cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+
+    if (max_leaf < 1)
+        return features;
+
+    _validus_cpuid(1, 0, regs);
+    if (regs[2] & (1U << 19))
+        features |= VALIDUS_CPU_SSE41;
+
+    /* AVX state must be enabled by the OS (OSXSAVE + XCR0), not just present. */
+    const bool osxsave = (regs[2] & (1U << 27)) != 0;
+    const bool avx     = (regs[2] & (1U << 28)) != 0;
+    uint64_t xcr0      = osxsave ? _validus_xgetbv() : 0;
+
+    if (max_leaf < 7)
+        return features;
+
+    _validus_cpuid(7, 0, regs);
+    if (regs[1] & (1U << 8))
+        features |= VALIDUS_CPU_BMI2;
+
+    if (avx && (xcr0 & 0x06U) == 0x06U && (regs[1] & (1U << 5)))
+        features |= VALIDUS_CPU_AVX2;
+
+    if ((xcr0 & 0xE6U) == 0xE6U && (regs[1] & (1U << 16)))
+        features |= VALIDUS_CPU_AVX512F;
+#endif
+
+    return features;
+}
+
+static const validus_kernel* _validus_kernel_select(void)
+{
+    const uint32_t features = _validus_cpu_features();
+    const validus_kernel* best = &_validus_kernels[VALIDUS_KERNEL_COUNT - 1];
+
+    for (size_t n = 0; n < VALIDUS_KERNEL_COUNT; n++) {
+        if ((_validus_kernels[n].requires & features) == _validus_kernels[n].requires) {
+            best = &_validus_kernels[n];
+            break;
+        }
+    }
+
+    const char* forced = getenv(VALIDUS_KERNEL_ENV);
+    if (!forced || !*forced)
+        return best;
+
+    for (size_t n = 0; n < VALIDUS_KERNEL_COUNT; n++) {
+        if (0 != strcmp(forced, _validus_kernels[n].name))
+            continue;
+
+        if ((_validus_kernels[n].requires & features) == _validus_kernels[n].requires)
+            return &_validus_kernels[n];
+
+        fprintf(stderr, "validus: kernel '%s' is not supported by this CPU; using '%s'\n",
+            forced, best->name);
+        return best;
+    }
+
+    fprintf(stderr, "validus: unknown kernel '%s'; using '%s'\n", forced, best->name);
+    return best;
+}
+
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+static void _validus_kernel_init(void)
+{
+    if (!_validus_active_kernel)
+        _validus_active_kernel = _validus_kernel_select();
+}
+
+#if defined(_MSC_VER)
+# pragma section(".CRT$XCU", read)
+__declspec(allocate(".CRT$XCU")) static void (*_validus_kernel_init_ptr)(void) =
+    &_validus_kernel_init;
+#endif
+
+const validus_kernel* _validus_kernel(void)
+{
+    if (!_validus_active_kernel)
+        _validus_kernel_init();
+
+    return _validus_active_kernel;
+}
+
+const validus_kernel* _validus_kernel_lanes(size_t count)
+{
+    const validus_kernel* active = _validus_kernel();
+
+    for (size_t n = 0; n < VALIDUS_KERNEL_COUNT; n++) {
+        const validus_kernel* k = &_validus_kernels[n];
+        if (k->lanes && k->nlanes <= count && (k->requires & active->requires) == k->requires)
+            return k;
+    }
+
+    return NULL;
+}
+
+const validus_kernel* _validus_kernel_at(size_t n)
+{
+    return n < VALIDUS_KERNEL_COUNT ? &_validus_kernels[n] : NULL;
+}
+
+bool _validus_kernel_supported(const validus_kernel* kernel)
+{
+    return (kernel->requires & _validus_cpu_features()) == kernel->requires;
+}
+
+const validus_kernel* _validus_kernel_use(const validus_kernel* kernel)
+{
+    const validus_kernel* previous = _validus_kernel();
+    _validus_active_kernel         = kernel;
+    return previous;
+}
+
+const char* validus_kernel_name(void)
+{
+    return _validus_kernel()->name;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file validuskernel.h
+ * @brief Internal definitions for the Validus compression kernels.
+ *
+ * Declares the per-ISA kernels and the table used to select one of them at
+ * run time, based on the features of the host CPU.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _VALIDUS_KERNEL_H_INCLUDED
+# define _VALIDUS_KERNEL_H_INCLUDED
+
+# include "validus.h"
+
+# if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#  if defined(__GNUC__) || defined(_MSC_VER)
+#   define VALIDUS_X86
+#  endif
+# endif
+
+# if defined(__GNUC__)
+#  define VALIDUS_TARGET(isa)  __attribute__((target(isa)))
+#  define VALIDUS_FORCEINLINE  inline __attribute__((always_inline))
+# elif defined(_MSC_VER)
+#  define VALIDUS_TARGET(isa)
+#  define VALIDUS_FORCEINLINE  __forceinline
+# else
+#  define VALIDUS_TARGET(isa)
+#  define VALIDUS_FORCEINLINE  inline
+# endif
+
+/** The name of the environment variable used to force a specific kernel. */
+# define VALIDUS_KERNEL_ENV "VALIDUS_KERNEL"
+
+/* CPU features a kernel may require. */
+# define VALIDUS_CPU_SSE41   0x01U /**< SSE4.1. */
+# define VALIDUS_CPU_BMI2    0x02U /**< BMI2 (rorx). */
+# define VALIDUS_CPU_AVX2    0x04U /**< AVX2, with OS support for YMM state. */
+# define VALIDUS_CPU_AVX512F 0x08U /**< AVX-512F, with OS support for ZMM state. */
+
+/** A single-block kernel: see ::_validus_process. */
+typedef void (*validus_process_fn)(validus_state* state, const validus_word* blk32);
+
+/**
+ * A finalization kernel: compresses the finalization block for the 64-bit
+ * counter `hi`:`lo`. Every other word of that block is constant, so their
+ * round terms are folded at compile time.
+ */
+typedef void (*validus_finalize_fn)(validus_state* state, validus_word hi, validus_word lo);
+
+/**
+ * A multi-buffer kernel: compresses one block in each of its lanes. `st` holds
+ * the six working variables and `blk` the 48 message words, each stored as a
+ * row of one word per lane.
+ */
+typedef void (*validus_lanes_fn)(validus_word* st, const validus_word* blk);
+
+/** An entry in the kernel table. */
+typedef struct {
+    const char* name;             /**< Name, as accepted by VALIDUS_KERNEL_ENV. */
+    uint32_t requires;            /**< Required VALIDUS_CPU_* features. */
+    validus_process_fn process;   /**< Single-block kernel. */
+    validus_finalize_fn finalize; /**< Finalization kernel. */
+    validus_lanes_fn lanes;       /**< Multi-buffer kernel, or NULL. */
+    size_t nlanes;                /**< Lane count of `lanes`. */
+} validus_kernel;
+
+# if defined(__cplusplus)
+extern "C" {
+# endif
+
+/** Generic single-block kernel (validus.c). */
+VALIDUS_API void _validus_process_generic(validus_state* state, const validus_word* blk32);
+
+VALIDUS_API void _validus_finalize_generic(validus_state* state, validus_word hi, validus_word lo);
+
+VALIDUS_API void _validus_process_compact(validus_state* state, const validus_word* blk32);
+
+VALIDUS_API void _validus_finalize_compact(validus_state* state, validus_word hi, validus_word lo);
+
+# if defined(VALIDUS_X86)
+/** Single-block kernel compiled for BMI2 (validus.c). */
+VALIDUS_API void _validus_process_bmi2(validus_state* state, const validus_word* blk32);
+
+VALIDUS_API void _validus_finalize_bmi2(validus_state* state, validus_word hi, validus_word lo);
+
+/** 4-lane SSE4.1 kernel (validusmb.c). */
+void _validus_lanes_sse41(validus_word* st, const validus_word* blk);
+
+/** 8-lane AVX2 kernel (validusmb.c). */
+void _validus_lanes_avx2(validus_word* st, const validus_word* blk);
+
+/** 16-lane AVX-512F kernel (validusmb.c). */
+void _validus_lanes_avx512(validus_word* st, const validus_word* blk);
+# endif
+
+/**
+ * Returns the kernel selected for this process. The selection is made once:
+ * the best kernel supported by the CPU, unless VALIDUS_KERNEL_ENV names a
+ * supported kernel.
+ */
+const validus_kernel* _validus_kernel(void);
+
+/**
+ * Returns the widest multi-buffer kernel that requires no more than the
+ * selected kernel does, and has at most `count` lanes; NULL if there is none.
+ */
+const validus_kernel* _validus_kernel_lanes(size_t count);
+
+/** Returns entry `n` of the kernel table, or NULL if there is no such entry. */
+const validus_kernel* _validus_kernel_at(size_t n);
+
+/** Returns whether the CPU supports `kernel`. */
+bool _validus_kernel_supported(const validus_kernel* kernel);
+
+/**
+ * Makes `kernel` (which must be supported) the selected kernel, and returns
+ * the one it replaces. For self-tests only: it is not safe while other threads
+ * are hashing.
+ */
+const validus_kernel* _validus_kernel_use(const validus_kernel* kernel);
+
+# if defined(__cplusplus)
+}
+# endif
+
+#endif /* !_VALIDUS_KERNEL_H_INCLUDED */
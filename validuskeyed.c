@@ -0,0 +1,142 @@
+/**
+ * @file validuskeyed.c
+ * @brief Implementation of the Validus keyed (MAC) mode.
+ *
+ * Computes keyed fingerprints with the HMAC construction, using midstates
+ * precomputed once per key.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusio.h"
+
+/** The octet XORed into the key to form the inner key block. */
+#define VALIDUS_KEYED_IPAD 0x36
+
+/** The octet XORed into the key to form the outer key block. */
+#define VALIDUS_KEYED_OPAD 0x5C
+
+/** Zeroes memory in a way the compiler may not optimize away. */
+static void _validus_keyed_zero(void* mem, size_t len)
+{
+    volatile validus_octet* ptr = (volatile validus_octet*)mem;
+    while (len-- > 0)
+        *ptr++ = 0;
+}
+
+bool validus_keyed_init(validus_keyed* keyed, const void* key, size_t len)
+{
+    if (!keyed || (!key && len > 0))
+        return false;
+
+    validus_word blk[VALIDUS_FP_SIZE_O];
+    validus_octet* octets = (validus_octet*)blk;
+    memset(blk, 0, sizeof(blk));
+
+    if (len > VALIDUS_FP_SIZE_B) {
+        validus_state digest;
+        validus_hash_mem(&digest, key, len);
+        _validus_fp_store(octets, &digest);
+        _validus_keyed_zero(&digest, sizeof(digest));
+    } else if (len > 0) {
+        memcpy(octets, key, len);
+    }
+
+    for (size_t n = 0; n < VALIDUS_FP_SIZE_B; n++)
+        octets[n] ^= VALIDUS_KEYED_IPAD;
+
+    validus_stream_init(&keyed->inner);
+    validus_stream_write(&keyed->inner, blk, VALIDUS_FP_SIZE_B);
+
+    for (size_t n = 0; n < VALIDUS_FP_SIZE_B; n++)
+        octets[n] ^= VALIDUS_KEYED_IPAD ^ VALIDUS_KEYED_OPAD;
+
+    validus_stream_init(&keyed->outer);
+    validus_stream_write(&keyed->outer, blk, VALIDUS_FP_SIZE_B);
+
+    _validus_keyed_zero(blk, sizeof(blk));
+    return true;
+}
+
+bool validus_keyed_start(const validus_keyed* keyed, validus_stream* stream)
+{
+    if (!keyed || !stream)
+        return false;
+
+    validus_stream_clone(stream, &keyed->inner);
+    return true;
+}
+
+bool validus_keyed_finalize(const validus_keyed* keyed, validus_stream* stream)
+{
+    if (!keyed || !stream)
+        return false;
+
+    validus_octet inner[VALIDUS_FP_OCTETS];
+    validus_stream_finalize(stream);
+    _validus_fp_store(inner, &stream->state);
+
+    validus_stream_clone(stream, &keyed->outer);
+    validus_stream_write(stream, inner, sizeof(inner));
+    validus_stream_finalize(stream);
+
+    return true;
+}
+
+bool validus_keyed_hash(const validus_keyed* keyed, validus_state* state,
+    const void* data, size_t len)
+{
+    if (!keyed || !state || (!data && len > 0))
+        return false;
+
+    validus_stream stream;
+    validus_keyed_start(keyed, &stream);
+    validus_stream_write(&stream, data, len);
+    validus_keyed_finalize(keyed, &stream);
+
+    *state = stream.state;
+    return true;
+}
+
+void validus_keyed_wipe(validus_keyed* keyed)
+{
+    if (!keyed)
+        return;
+
+    _validus_keyed_zero(keyed, sizeof(*keyed));
+}
+
+bool validus_compare_ct(const validus_state* one, const validus_state* two)
+{
+    if (!one || !two)
+        return false;
+
+    volatile validus_word diff = 0;
+    diff |= one->f0 ^ two->f0;
+    diff |= one->f1 ^ two->f1;
+    diff |= one->f2 ^ two->f2;
+    diff |= one->f3 ^ two->f3;
+    diff |= one->f4 ^ two->f4;
+    diff |= one->f5 ^ two->f5;
+
+    return diff == 0;
+}
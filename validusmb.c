@@ -0,0 +1,401 @@
+/**
+ * @file validusmb.c
+ * @brief Multi-buffer implementation of the Validus hash function.
+ *
+ * Hashes many independent messages at once by running the compression function
+ * in lockstep across the lanes of a vector register (one message per lane).
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validuskernel.h"
+#include "validusrounds.h"
+#include "validusstats.h"
+#include <string.h>
+
+#if defined(VALIDUS_X86)
+# include <immintrin.h>
+#endif
+
+/** The lane count of the widest kernel (AVX-512). */
+#define VALIDUS_MB_MAX_LANES 16
+
+/** The number of working variables (f0..f5) in a validus_state. */
+#define VALIDUS_MB_WORDS 6
+
+/** Where each lane is in the processing of its current message. */
+typedef enum {
+    VALIDUS_LANE_IDLE = 0, /**< No message assigned. */
+    VALIDUS_LANE_DATA,     /**< Message blocks remain. */
+    VALIDUS_LANE_FINAL     /**< Only the finalization block remains. */
+} validus_lane_phase;
+
+/** Per-lane bookkeeping for the message currently assigned to it. */
+typedef struct {
+    const validus_octet* ptr; /**< Next unprocessed octet of the message. */
+    size_t left;              /**< Octets of the message yet to be processed. */
+    size_t idx;               /**< Index of the message in the caller's arrays. */
+    validus_word bits[2];     /**< 64-bit counter, as validus_append computes it. */
+    validus_lane_phase phase; /**< Current phase. */
+} validus_lane;
+
+/**
+ * The working state of a batch of lanes, stored structure-of-arrays fashion:
+ * word `w` of lane `l` lives at `[w * lanes + l]`, so that a vector load of row
+ * `w` yields that word for every lane.
+ */
+typedef struct {
+    _Alignas(64) validus_word st[VALIDUS_MB_WORDS * VALIDUS_MB_MAX_LANES];
+    _Alignas(64) validus_word blk[VALIDUS_FP_SIZE_O * VALIDUS_MB_MAX_LANES];
+    validus_lane lane[VALIDUS_MB_MAX_LANES];
+    size_t lanes;
+} validus_state_batch;
+
+/////////////////////////////// vector kernels /////////////////////////////////
+
+#if defined(VALIDUS_X86)
+
+/*
+ * The kernel body is written once in terms of V_* operations, which are
+ * (re)defined for each instruction set before the body is expanded.
+ */
+# define _VALIDUS_MB_M0(a, b, c, d, e) \
+    V_XOR(V_AND(a, b), V_XOR(V_AND(c, d), e))
+# define _VALIDUS_MB_M1(a, b, c, d, e) \
+    V_XOR(V_AND(a, b), V_XOR(V_XOR(b, V_AND(c, d)), e))
+# define _VALIDUS_MB_M2(a, b, c, d, e) \
+    V_XOR(V_XOR(V_AND(a, V_XOR(b, c)), V_ANDN(d, e)), c)
+# define _VALIDUS_MB_M3(a, b, c, d, e) \
+    V_XOR(V_XOR(V_AND(a, b), V_AND(c, V_XOR(d, e))), e)
+
+# define _VALIDUS_MB_VC(M, a, b, c, d, e, f, r1, r2, i, k)                       \
+    do {                                                                      \
+        V_T w = V_LOAD(&blk[(i) * V_LANES]);                                  \
+        V_T t = V_ADD(V_ADD(a, M(b, c, d, e, f)),                             \
+            V_ROL(V_ADD(w, V_SET1(k)), r1));                                  \
+        a     = V_ROR(V_ADD(t, w), r2);                                       \
+    } while (false);
+
+# define _VALIDUS_MB_R0(a, b, c, d, e, f, r1, r2, i, k) \
+    _VALIDUS_MB_VC(_VALIDUS_MB_M0, a, b, c, d, e, f, r1, r2, i, k)
+# define _VALIDUS_MB_R1(a, b, c, d, e, f, r1, r2, i, k) \
+    _VALIDUS_MB_VC(_VALIDUS_MB_M1, a, b, c, d, e, f, r1, r2, i, k)
+# define _VALIDUS_MB_R2(a, b, c, d, e, f, r1, r2, i, k) \
+    _VALIDUS_MB_VC(_VALIDUS_MB_M2, a, b, c, d, e, f, r1, r2, i, k)
+# define _VALIDUS_MB_R3(a, b, c, d, e, f, r1, r2, i, k) \
+    _VALIDUS_MB_VC(_VALIDUS_MB_M3, a, b, c, d, e, f, r1, r2, i, k)
+
+# define _VALIDUS_MB_KERNEL_BODY                                          \
+    V_T a = V_LOAD(&st[0 * V_LANES]);                                    \
+    V_T b = V_LOAD(&st[1 * V_LANES]);                                    \
+    V_T c = V_LOAD(&st[2 * V_LANES]);                                    \
+    V_T d = V_LOAD(&st[3 * V_LANES]);                                    \
+    V_T e = V_LOAD(&st[4 * V_LANES]);                                    \
+    V_T f = V_LOAD(&st[5 * V_LANES]);                                    \
+                                                                         \
+    VALIDUS_ROUNDS(_VALIDUS_MB_R0, _VALIDUS_MB_R1, _VALIDUS_MB_R2,       \
+        _VALIDUS_MB_R3)                                                  \
+                                                                         \
+    V_STORE(&st[0 * V_LANES], V_ADD(V_LOAD(&st[0 * V_LANES]), a));       \
+    V_STORE(&st[1 * V_LANES], V_ADD(V_LOAD(&st[1 * V_LANES]), b));       \
+    V_STORE(&st[2 * V_LANES], V_ADD(V_LOAD(&st[2 * V_LANES]), c));       \
+    V_STORE(&st[3 * V_LANES], V_ADD(V_LOAD(&st[3 * V_LANES]), d));       \
+    V_STORE(&st[4 * V_LANES], V_ADD(V_LOAD(&st[4 * V_LANES]), e));       \
+    V_STORE(&st[5 * V_LANES], V_ADD(V_LOAD(&st[5 * V_LANES]), f))
+
+/* SSE4.1: 4 lanes. */
+# define V_T           __m128i
+# define V_LANES       4
+# define V_LOAD(p)     _mm_load_si128((const __m128i*)(p))
+# define V_STORE(p, x) _mm_store_si128((__m128i*)(p), x)
+# define V_SET1(k)     _mm_set1_epi32((int)(k))
+# define V_ADD(x, y)   _mm_add_epi32(x, y)
+# define V_AND(x, y)   _mm_and_si128(x, y)
+# define V_XOR(x, y)   _mm_xor_si128(x, y)
+# define V_ANDN(x, y)  _mm_andnot_si128(x, y)
+# define V_ROL(x, n)   _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - (n)))
+# define V_ROR(x, n)   _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - (n)))
+
+VALIDUS_TARGET("sse4.1")
+void _validus_lanes_sse41(validus_word* st, const validus_word* blk)
+{
+    _VALIDUS_MB_KERNEL_BODY;
+}
+
+# undef V_T
+# undef V_LANES
+# undef V_LOAD
+# undef V_STORE
+# undef V_SET1
+# undef V_ADD
+# undef V_AND
+# undef V_XOR
+# undef V_ANDN
+# undef V_ROL
+# undef V_ROR
+
+/* AVX2: 8 lanes. */
+# define V_T           __m256i
+# define V_LANES       8
+# define V_LOAD(p)     _mm256_load_si256((const __m256i*)(p))
+# define V_STORE(p, x) _mm256_store_si256((__m256i*)(p), x)
+# define V_SET1(k)     _mm256_set1_epi32((int)(k))
+# define V_ADD(x, y)   _mm256_add_epi32(x, y)
+# define V_AND(x, y)   _mm256_and_si256(x, y)
+# define V_XOR(x, y)   _mm256_xor_si256(x, y)
+# define V_ANDN(x, y)  _mm256_andnot_si256(x, y)
+# define V_ROL(x, n)   _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+# define V_ROR(x, n)   _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+VALIDUS_TARGET("avx2")
+void _validus_lanes_avx2(validus_word* st, const validus_word* blk)
+{
+    _VALIDUS_MB_KERNEL_BODY;
+}
+
+# undef V_T
+# undef V_LANES
+# undef V_LOAD
+# undef V_STORE
+# undef V_SET1
+# undef V_ADD
+# undef V_AND
+# undef V_XOR
+# undef V_ANDN
+# undef V_ROL
+# undef V_ROR
+
+/* AVX-512F: 16 lanes, with native rotates. */
+# define V_T           __m512i
+# define V_LANES       16
+# define V_LOAD(p)     _mm512_load_si512((const void*)(p))
+# define V_STORE(p, x) _mm512_store_si512((void*)(p), x)
+# define V_SET1(k)     _mm512_set1_epi32((int)(k))
+# define V_ADD(x, y)   _mm512_add_epi32(x, y)
+# define V_AND(x, y)   _mm512_and_si512(x, y)
+# define V_XOR(x, y)   _mm512_xor_si512(x, y)
+# define V_ANDN(x, y)  _mm512_andnot_si512(x, y)
+# define V_ROL(x, n)   _mm512_rol_epi32(x, n)
+# define V_ROR(x, n)   _mm512_ror_epi32(x, n)
+
+VALIDUS_TARGET("avx512f")
+void _validus_lanes_avx512(validus_word* st, const validus_word* blk)
+{
+    _VALIDUS_MB_KERNEL_BODY;
+}
+
+# undef V_T
+# undef V_LANES
+# undef V_LOAD
+# undef V_STORE
+# undef V_SET1
+# undef V_ADD
+# undef V_AND
+# undef V_XOR
+# undef V_ANDN
+# undef V_ROL
+# undef V_ROR
+
+#endif /* VALIDUS_X86 */
+
+/////////////////////////////// lane scheduling ////////////////////////////////
+
+/** Reads a little-endian word from a (possibly unaligned) address. */
+static inline validus_word _validus_mb_load(const validus_octet* p)
+{
+    validus_word w;
+    OCTETSWAP(w, p);
+    return w;
+}
+
+/** Assigns message `idx` to lane `l`, or idles the lane if none remain. */
+static void _validus_mb_assign(validus_state_batch* batch, size_t l,
+    const void* const* data, const size_t* lens, size_t idx, size_t count)
+{
+    validus_lane* lane = &batch->lane[l];
+
+    if (idx >= count) {
+        lane->phase = VALIDUS_LANE_IDLE;
+        return;
+    }
+
+    lane->ptr   = (const validus_octet*)data[idx];
+    lane->left  = lens[idx];
+    lane->idx   = idx;
+    lane->phase = lane->left > 0 ? VALIDUS_LANE_DATA : VALIDUS_LANE_FINAL;
+
+    /* mirrors the counter arithmetic of a single validus_append call. */
+    lane->bits[1] = (validus_word)(lane->left >> 29);
+    lane->bits[0] = (validus_word)(lane->left << 3);
+    if (lane->bits[0] < (lane->left << 3))
+        lane->bits[1]++;
+
+    const validus_word init[VALIDUS_MB_WORDS] = {
+        VALIDUS_INIT_0, VALIDUS_INIT_1, VALIDUS_INIT_2,
+        VALIDUS_INIT_3, VALIDUS_INIT_4, VALIDUS_INIT_5
+    };
+
+    for (size_t w = 0; w < VALIDUS_MB_WORDS; w++)
+        batch->st[w * batch->lanes + l] = init[w];
+}
+
+/**
+ * Transposes the next block of lane `l` into its column of the batch's block
+ * matrix. Returns true if that block is the finalization block.
+ */
+static bool _validus_mb_gather(validus_state_batch* batch, size_t l)
+{
+    validus_lane* lane   = &batch->lane[l];
+    validus_word* column = &batch->blk[l];
+    const size_t stride  = batch->lanes;
+
+    if (lane->phase == VALIDUS_LANE_FINAL) {
+        for (size_t w = 0; w < VALIDUS_FP_SIZE_O; w++)
+            column[w * stride] = 0;
+        column[0]                                = 0xAA;
+        column[(VALIDUS_FP_SIZE_O - 2) * stride] = lane->bits[1];
+        column[(VALIDUS_FP_SIZE_O - 1) * stride] = lane->bits[0];
+        return true;
+    }
+
+    const validus_octet* src = lane->ptr;
+    validus_octet pad[VALIDUS_FP_SIZE_B];
+
+    if (lane->left >= VALIDUS_FP_SIZE_B) {
+        lane->ptr  += VALIDUS_FP_SIZE_B;
+        lane->left -= VALIDUS_FP_SIZE_B;
+    } else {
+        memcpy(pad, lane->ptr, lane->left);
+        memset(pad + lane->left, 0, VALIDUS_FP_SIZE_B - lane->left);
+        src        = pad;
+        lane->left = 0;
+    }
+
+    for (size_t w = 0; w < VALIDUS_FP_SIZE_O; w++)
+        column[w * stride] = _validus_mb_load(src + (w * sizeof(validus_word)));
+
+    if (lane->left == 0)
+        lane->phase = VALIDUS_LANE_FINAL;
+
+    return false;
+}
+
+/** Copies the finished fingerprint in lane `l` to the caller's state. */
+static void _validus_mb_emit(const validus_state_batch* batch, size_t l,
+    validus_state* out)
+{
+    const validus_lane* lane = &batch->lane[l];
+    const size_t stride      = batch->lanes;
+
+    out->bits[0] = lane->bits[0];
+    out->bits[1] = lane->bits[1];
+    OCTETSWAP(out->bits[1], ((validus_octet*)&out->bits[1]));
+    OCTETSWAP(out->bits[0], ((validus_octet*)&out->bits[0]));
+
+    out->f0 = batch->st[0 * stride + l];
+    out->f1 = batch->st[1 * stride + l];
+    out->f2 = batch->st[2 * stride + l];
+    out->f3 = batch->st[3 * stride + l];
+    out->f4 = batch->st[4 * stride + l];
+    out->f5 = batch->st[5 * stride + l];
+}
+
+static void _validus_mb_run(validus_lanes_fn kernel, size_t lanes,
+    validus_state* states, const void* const* data, const size_t* lens,
+    size_t count)
+{
+    validus_state_batch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.lanes = lanes;
+
+    size_t next   = 0;
+    size_t active = 0;
+
+    for (size_t l = 0; l < lanes; l++) {
+        _validus_mb_assign(&batch, l, data, lens, next++, count);
+        if (batch.lane[l].phase != VALIDUS_LANE_IDLE)
+            active++;
+    }
+
+    while (active > 0) {
+        bool finishing[VALIDUS_MB_MAX_LANES] = {false};
+
+        for (size_t l = 0; l < lanes; l++) {
+            if (batch.lane[l].phase != VALIDUS_LANE_IDLE)
+                finishing[l] = _validus_mb_gather(&batch, l);
+        }
+
+        kernel(batch.st, batch.blk);
+
+        for (size_t l = 0; l < lanes; l++) {
+            if (!finishing[l])
+                continue;
+
+            _validus_mb_emit(&batch, l, &states[batch.lane[l].idx]);
+            _validus_mb_assign(&batch, l, data, lens, next++, count);
+            if (batch.lane[l].phase == VALIDUS_LANE_IDLE)
+                active--;
+        }
+    }
+}
+
+bool validus_hash_many(validus_state* states, const void* const* data,
+    const size_t* lens, size_t count)
+{
+    if (count == 0)
+        return true;
+
+    if (!states || !data || !lens)
+        return false;
+
+    for (size_t n = 0; n < count; n++) {
+        if (!data[n] && lens[n] > 0)
+            return false;
+    }
+
+    const validus_kernel* kernel = _validus_kernel_lanes(count);
+    if (kernel) {
+        _validus_mb_run(kernel->lanes, kernel->nlanes, states, data, lens, count);
+
+        for (size_t n = 0; n < count; n++) {
+            VALIDUS_STAT_ADD(VALIDUS_STAT_BYTES, lens[n]);
+            VALIDUS_STAT_ADD(VALIDUS_STAT_FULL_BLOCKS, lens[n] / VALIDUS_FP_SIZE_B);
+            VALIDUS_STAT_ADD(VALIDUS_STAT_PADDED_TAILS, 0 != lens[n] % VALIDUS_FP_SIZE_B);
+        }
+        VALIDUS_STAT_ADD(VALIDUS_STAT_FINALIZES, count);
+
+        return true;
+    }
+
+    for (size_t n = 0; n < count; n++) {
+        if (lens[n] <= VALIDUS_FP_SIZE_B) {
+            _validus_hash_short(&states[n], data[n], lens[n]);
+            continue;
+        }
+
+        validus_init(&states[n]);
+        validus_append(&states[n], data[n], lens[n]);
+        validus_finalize(&states[n]);
+    }
+
+    return true;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file validusperf.c
+ * @brief Implementation of the benchmark performance counters.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusperf.h"
+
+#if defined(VALIDUS_HAVE_PERF_EVENT)
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+bool validus_perf_open(validus_perf* perf)
+{
+    if (!perf)
+        return false;
+
+    bool any = false;
+
+    for (size_t n = 0; n < VALIDUS_PERF_NCOUNTERS; n++) {
+        perf->fds[n]    = -1;
+        perf->values[n] = 0ULL;
+    }
+    perf->unscheduled = false;
+
+#if defined(VALIDUS_HAVE_PERF_EVENT)
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[VALIDUS_PERF_NCOUNTERS] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1I | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+    };
+
+    /* one group, so that the counters are scheduled (and multiplexed)
+     * together: the first to open leads it, and is the only one enabled,
+     * disabled and read. an event that cannot join is unavailable. */
+    int leader = -1;
+
+    for (size_t n = 0; n < VALIDUS_PERF_NCOUNTERS; n++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = events[n].type;
+        attr.config         = events[n].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        if (leader < 0)
+            attr.disabled = 1;
+        attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+            PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        long fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0UL);
+        if (fd >= 0) {
+            perf->fds[n] = (int)fd;
+            any          = true;
+            if (leader < 0)
+                leader = (int)fd;
+        }
+    }
+#endif
+
+    return any;
+}
+
+bool validus_perf_has(const validus_perf* perf, validus_perf_counter counter)
+{
+    return perf && counter < VALIDUS_PERF_NCOUNTERS && perf->fds[counter] >= 0 &&
+        !perf->unscheduled;
+}
+
+void validus_perf_reset(validus_perf* perf)
+{
+    for (size_t n = 0; perf && n < VALIDUS_PERF_NCOUNTERS; n++)
+        perf->values[n] = 0ULL;
+    if (perf)
+        perf->unscheduled = false;
+}
+
+#if defined(VALIDUS_HAVE_PERF_EVENT)
+/** The descriptor of the group leader, or -1 if no counter is open. */
+static int _validus_perf_leader(const validus_perf* perf)
+{
+    for (size_t n = 0; perf && n < VALIDUS_PERF_NCOUNTERS; n++) {
+        if (perf->fds[n] >= 0)
+            return perf->fds[n];
+    }
+    return -1;
+}
+#endif
+
+void validus_perf_start(validus_perf* perf)
+{
+#if defined(VALIDUS_HAVE_PERF_EVENT)
+    int leader = _validus_perf_leader(perf);
+    if (leader >= 0) {
+        (void)ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        (void)ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#else
+    (void)perf;
+#endif
+}
+
+void validus_perf_stop(validus_perf* perf)
+{
+#if defined(VALIDUS_HAVE_PERF_EVENT)
+    int leader = _validus_perf_leader(perf);
+    if (leader < 0)
+        return;
+
+    (void)ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    /* the number of counters, time enabled, time running, then the values in
+     * the order the counters joined the group. they share one interval, so
+     * scaling (if the group was multiplexed) keeps their ratios. */
+    uint64_t read_buf[3 + VALIDUS_PERF_NCOUNTERS] = {0};
+    ssize_t got = read(leader, read_buf, sizeof(read_buf));
+
+    if (got < (ssize_t)(3 * sizeof(uint64_t)) || 0ULL == read_buf[2] ||
+        (size_t)got < (3 + read_buf[0]) * sizeof(uint64_t)) {
+        perf->unscheduled = true;
+        return;
+    }
+
+    double scale = (double)read_buf[1] / (double)read_buf[2];
+    size_t value = 3;
+
+    for (size_t n = 0; n < VALIDUS_PERF_NCOUNTERS && value < 3 + read_buf[0]; n++) {
+        if (perf->fds[n] >= 0)
+            perf->values[n] += (uint64_t)((double)read_buf[value++] * scale);
+    }
+#else
+    (void)perf;
+#endif
+}
+
+void validus_perf_close(validus_perf* perf)
+{
+    for (size_t n = 0; perf && n < VALIDUS_PERF_NCOUNTERS; n++) {
+#if defined(VALIDUS_HAVE_PERF_EVENT)
+        if (perf->fds[n] >= 0)
+            (void)close(perf->fds[n]);
+#endif
+        perf->fds[n] = -1;
+    }
+}
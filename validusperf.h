@@ -0,0 +1,85 @@
+/**
+ * @file validusperf.h
+ * @brief Hardware performance counters for the benchmarks (perf_event_open).
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _VALIDUS_PERF_H_INCLUDED
+# define _VALIDUS_PERF_H_INCLUDED
+
+# include "validusutil.h"
+
+/////////////////////////////// typedefs ///////////////////////////////////////
+
+/** The hardware events that are counted. */
+typedef enum {
+    VALIDUS_PERF_CYCLES = 0,   /**< CPU cycles. */
+    VALIDUS_PERF_INSTRUCTIONS, /**< Retired instructions. */
+    VALIDUS_PERF_L1I_MISSES,   /**< L1 instruction cache read misses. */
+    VALIDUS_PERF_BRANCH_MISSES, /**< Mispredicted branches. */
+    VALIDUS_PERF_NCOUNTERS
+} validus_perf_counter;
+
+/**
+ * A set of hardware performance counters for the calling thread, opened as one
+ * group (led by the first counter available, normally cycles), so that they
+ * are all counted over the same intervals. Counters the kernel or hardware does
+ * not provide are left closed, and read as zero.
+ */
+typedef struct {
+    int fds[VALIDUS_PERF_NCOUNTERS];          /**< -1 if unavailable. */
+    uint64_t values[VALIDUS_PERF_NCOUNTERS];  /**< Totals since the last reset. */
+    bool unscheduled;                         /**< The group was not scheduled for
+                                                   an interval since the last reset,
+                                                   so the totals are unavailable. */
+} validus_perf;
+
+///////////////////////////// function exports /////////////////////////////////
+
+# if defined(__cplusplus)
+extern "C" {
+# endif
+
+/** Opens the counters; returns false (timing only) if none are available. */
+bool validus_perf_open(validus_perf* perf);
+
+/** Returns whether counter `counter` is available, and has been counted for
+ * every interval since the last reset. */
+bool validus_perf_has(const validus_perf* perf, validus_perf_counter counter);
+
+/** Zeroes the totals. */
+void validus_perf_reset(validus_perf* perf);
+
+/** Starts counting. */
+void validus_perf_start(validus_perf* perf);
+
+/** Stops counting, and adds the counts since ::validus_perf_start to the totals. */
+void validus_perf_stop(validus_perf* perf);
+
+void validus_perf_close(validus_perf* perf);
+
+# if defined(__cplusplus)
+}
+# endif
+
+#endif /* !_VALIDUS_PERF_H_INCLUDED */
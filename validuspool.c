@@ -0,0 +1,539 @@
+/**
+ * @file validuspool.c
+ * @brief Implementation of the internal threading primitives and thread pool.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE 1
+#endif
+
+#include "validuspool.h"
+
+#if defined(__linux__)
+# include <sched.h>
+#endif
+
+#if !defined(__WIN__)
+# include <unistd.h>
+#endif
+
+typedef struct {
+    validus_thread_fn fn;
+    void* arg;
+} validus_thread_start;
+
+#if defined(__WIN__)
+static DWORD WINAPI _validus_thread_entry(LPVOID param)
+#else
+static void* _validus_thread_entry(void* param)
+#endif
+{
+    validus_thread_start start = *(validus_thread_start*)param;
+    free(param);
+    start.fn(start.arg);
+#if defined(__WIN__)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+bool _validus_thread_create(validus_thread* thread, validus_thread_fn fn, void* arg)
+{
+    validus_thread_start* start = calloc(1, sizeof(validus_thread_start));
+    if (!start)
+        return false;
+
+    start->fn  = fn;
+    start->arg = arg;
+
+#if defined(__WIN__)
+    *thread = CreateThread(NULL, 0, &_validus_thread_entry, start, 0, NULL);
+    if (!*thread) {
+        free(start);
+        return false;
+    }
+#else
+    int ret = pthread_create(thread, NULL, &_validus_thread_entry, start);
+    if (0 != ret) {
+        fprintf(stderr, "pthread_create() failed: %d\n", ret);
+        free(start);
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+void _validus_thread_join(validus_thread thread)
+{
+#if defined(__WIN__)
+    (void)WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    (void)pthread_join(thread, NULL);
+#endif
+}
+
+void _validus_mutex_init(validus_mutex* mutex)
+{
+#if defined(__WIN__)
+    InitializeSRWLock(mutex);
+#else
+    (void)pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void _validus_mutex_destroy(validus_mutex* mutex)
+{
+#if defined(__WIN__)
+    (void)mutex;
+#else
+    (void)pthread_mutex_destroy(mutex);
+#endif
+}
+
+void _validus_mutex_lock(validus_mutex* mutex)
+{
+#if defined(__WIN__)
+    AcquireSRWLockExclusive(mutex);
+#else
+    (void)pthread_mutex_lock(mutex);
+#endif
+}
+
+void _validus_mutex_unlock(validus_mutex* mutex)
+{
+#if defined(__WIN__)
+    ReleaseSRWLockExclusive(mutex);
+#else
+    (void)pthread_mutex_unlock(mutex);
+#endif
+}
+
+void _validus_cond_init(validus_cond* cond)
+{
+#if defined(__WIN__)
+    InitializeConditionVariable(cond);
+#else
+    (void)pthread_cond_init(cond, NULL);
+#endif
+}
+
+void _validus_cond_destroy(validus_cond* cond)
+{
+#if defined(__WIN__)
+    (void)cond;
+#else
+    (void)pthread_cond_destroy(cond);
+#endif
+}
+
+void _validus_cond_wait(validus_cond* cond, validus_mutex* mutex)
+{
+#if defined(__WIN__)
+    (void)SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+#else
+    (void)pthread_cond_wait(cond, mutex);
+#endif
+}
+
+void _validus_cond_signal(validus_cond* cond)
+{
+#if defined(__WIN__)
+    WakeConditionVariable(cond);
+#else
+    (void)pthread_cond_signal(cond);
+#endif
+}
+
+void _validus_cond_broadcast(validus_cond* cond)
+{
+#if defined(__WIN__)
+    WakeAllConditionVariable(cond);
+#else
+    (void)pthread_cond_broadcast(cond);
+#endif
+}
+
+#if defined(__linux__)
+/** Reads up to two integers (or "max", as -1) from a cgroup control file. */
+static int _validus_cgroup_read(const char* file, long long* a, long long* b)
+{
+    FILE* fp = fopen(file, "r");
+    if (!fp)
+        return 0;
+
+    char first[32] = {0};
+    int fields     = fscanf(fp, "%31s %lld", first, b);
+    (void)fclose(fp);
+
+    if (fields < 1)
+        return 0;
+
+    *a = 0 == strcmp(first, "max") ? -1LL : strtoll(first, NULL, 10);
+    return fields;
+}
+
+/** Returns the CPU limit imposed by the cgroup CFS quota, or 0 if none. */
+static size_t _validus_cgroup_cpus(void)
+{
+    long long quota = -1LL, period = 0LL;
+
+    /* cgroup v2: "<quota|max> <period>"; v1: separate quota and period files. */
+    if (2 != _validus_cgroup_read("/sys/fs/cgroup/cpu.max", &quota, &period)) {
+        long long unused = 0LL;
+        if (_validus_cgroup_read("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", &quota, &unused) < 1 ||
+            _validus_cgroup_read("/sys/fs/cgroup/cpu/cpu.cfs_period_us", &period, &unused) < 1)
+            return 0;
+    }
+
+    if (quota <= 0LL || period <= 0LL)
+        return 0;
+
+    return (size_t)((quota + period - 1LL) / period);
+}
+#endif
+
+size_t validus_cpu_count(void)
+{
+#if defined(__WIN__)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (size_t)si.dwNumberOfProcessors : 1;
+#else
+    long online  = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t count = online > 0 ? (size_t)online : 1;
+# if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (0 == sched_getaffinity(0, sizeof(set), &set) && CPU_COUNT(&set) > 0)
+        count = (size_t)CPU_COUNT(&set);
+
+    size_t quota = _validus_cgroup_cpus();
+    if (quota > 0 && quota < count)
+        count = quota;
+# endif
+    return count;
+#endif
+}
+
+////////////////////////////////// pool ////////////////////////////////////////
+
+typedef struct {
+    validus_mutex lock;
+    validus_task_fn fn;
+    void* ctx;
+    size_t next;
+    size_t count;
+} validus_pool;
+
+typedef struct {
+    validus_pool* pool;
+    size_t worker;
+} validus_pool_worker;
+
+static void _validus_pool_worker(void* arg)
+{
+    validus_pool_worker* self = (validus_pool_worker*)arg;
+    validus_pool* pool        = self->pool;
+
+    for (;;) {
+        _validus_mutex_lock(&pool->lock);
+        size_t idx = pool->next < pool->count ? pool->next++ : pool->count;
+        _validus_mutex_unlock(&pool->lock);
+
+        if (idx >= pool->count)
+            break;
+
+        pool->fn(pool->ctx, self->worker, idx);
+    }
+}
+
+bool _validus_parallel_for(size_t threads, size_t count, validus_task_fn fn, void* ctx)
+{
+    if (!fn)
+        return false;
+
+    if (count == 0)
+        return true;
+
+    if (threads == 0)
+        threads = validus_cpu_count();
+
+    if (threads > count)
+        threads = count;
+
+    validus_pool pool = {0};
+    _validus_mutex_init(&pool.lock);
+    pool.fn    = fn;
+    pool.ctx   = ctx;
+    pool.count = count;
+
+    validus_thread* handles     = calloc(threads, sizeof(validus_thread));
+    validus_pool_worker* workers = calloc(threads, sizeof(validus_pool_worker));
+
+    if (!handles || !workers) {
+        free(handles);
+        free(workers);
+        _validus_mutex_destroy(&pool.lock);
+        return false;
+    }
+
+    /* the calling thread is worker 0. */
+    size_t started = 0;
+    for (size_t n = 1; n < threads; n++) {
+        workers[n].pool   = &pool;
+        workers[n].worker = n;
+        if (!_validus_thread_create(&handles[n], &_validus_pool_worker, &workers[n]))
+            break;
+        started = n;
+    }
+
+    workers[0].pool   = &pool;
+    workers[0].worker = 0;
+    _validus_pool_worker(&workers[0]);
+
+    for (size_t n = 1; n <= started; n++)
+        _validus_thread_join(handles[n]);
+
+    free(handles);
+    free(workers);
+    _validus_mutex_destroy(&pool.lock);
+
+    return true;
+}
+
+//////////////////////////// work-stealing pool ////////////////////////////////
+
+/** A worker's deque: a growable ring of jobs. */
+typedef struct {
+    validus_mutex lock;
+    void** jobs;
+    size_t cap;
+    size_t head; /**< Index of the oldest job. */
+    size_t count;
+} validus_ws_deque;
+
+typedef struct {
+    validus_ws_pool* pool;
+    size_t worker;
+} validus_ws_worker;
+
+struct validus_ws_pool {
+    validus_ws_deque* deques;
+    validus_ws_worker* workers;
+    validus_thread* threads;
+    size_t nthreads; /**< Number of deques. */
+    size_t started;  /**< Number of running workers; they steal from every deque. */
+    validus_job_fn fn;
+    void* ctx;
+    validus_mutex lock; /**< Protects `queued`, `next` and `closing`. */
+    validus_cond cond;  /**< Signalled when jobs are queued, or upon closing. */
+    size_t queued;      /**< Jobs submitted, but not yet taken. */
+    size_t next;        /**< The deque to receive the next job. */
+    bool closing;
+};
+
+static bool _validus_ws_push(validus_ws_deque* dq, void* job)
+{
+    _validus_mutex_lock(&dq->lock);
+
+    if (dq->count == dq->cap) {
+        size_t cap  = dq->cap ? dq->cap * 2 : 64;
+        void** jobs = calloc(cap, sizeof(void*));
+        if (!jobs) {
+            _validus_mutex_unlock(&dq->lock);
+            return false;
+        }
+        for (size_t n = 0; n < dq->count; n++)
+            jobs[n] = dq->jobs[(dq->head + n) % dq->cap];
+        free(dq->jobs);
+        dq->jobs = jobs;
+        dq->cap  = cap;
+        dq->head = 0;
+    }
+
+    dq->jobs[(dq->head + dq->count) % dq->cap] = job;
+    dq->count++;
+
+    _validus_mutex_unlock(&dq->lock);
+    return true;
+}
+
+/** Takes the oldest job (owner) or the newest (thief); NULL if empty. */
+static void* _validus_ws_take(validus_ws_deque* dq, bool steal)
+{
+    void* job = NULL;
+
+    _validus_mutex_lock(&dq->lock);
+    if (dq->count > 0) {
+        if (steal) {
+            job = dq->jobs[(dq->head + dq->count - 1) % dq->cap];
+        } else {
+            job      = dq->jobs[dq->head];
+            dq->head = (dq->head + 1) % dq->cap;
+        }
+        dq->count--;
+    }
+    _validus_mutex_unlock(&dq->lock);
+
+    return job;
+}
+
+static void _validus_ws_run(void* arg)
+{
+    validus_ws_worker* self = (validus_ws_worker*)arg;
+    validus_ws_pool* pool   = self->pool;
+
+    for (;;) {
+        void* job = _validus_ws_take(&pool->deques[self->worker], false);
+
+        for (size_t n = 1; !job && n < pool->nthreads; n++)
+            job = _validus_ws_take(&pool->deques[(self->worker + n) % pool->nthreads], true);
+
+        if (job) {
+            _validus_mutex_lock(&pool->lock);
+            pool->queued--;
+            _validus_mutex_unlock(&pool->lock);
+
+            pool->fn(pool->ctx, self->worker, job);
+            continue;
+        }
+
+        _validus_mutex_lock(&pool->lock);
+        while (0 == pool->queued && !pool->closing)
+            _validus_cond_wait(&pool->cond, &pool->lock);
+        bool done = 0 == pool->queued && pool->closing;
+        _validus_mutex_unlock(&pool->lock);
+
+        if (done)
+            return;
+    }
+}
+
+static void _validus_ws_free(validus_ws_pool* pool)
+{
+    for (size_t n = 0; n < pool->nthreads; n++) {
+        free(pool->deques[n].jobs);
+        _validus_mutex_destroy(&pool->deques[n].lock);
+    }
+
+    _validus_cond_destroy(&pool->cond);
+    _validus_mutex_destroy(&pool->lock);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
+
+validus_ws_pool* _validus_ws_create(size_t threads, validus_job_fn fn, void* ctx)
+{
+    if (!fn)
+        return NULL;
+
+    if (threads == 0)
+        threads = validus_cpu_count();
+
+    validus_ws_pool* pool = calloc(1, sizeof(validus_ws_pool));
+    if (!pool)
+        return NULL;
+
+    pool->deques  = calloc(threads, sizeof(validus_ws_deque));
+    pool->workers = calloc(threads, sizeof(validus_ws_worker));
+    pool->threads = calloc(threads, sizeof(validus_thread));
+    pool->fn      = fn;
+    pool->ctx     = ctx;
+
+    _validus_mutex_init(&pool->lock);
+    _validus_cond_init(&pool->cond);
+
+    if (!pool->deques || !pool->workers || !pool->threads) {
+        _validus_ws_free(pool);
+        return NULL;
+    }
+
+    for (size_t n = 0; n < threads; n++)
+        _validus_mutex_init(&pool->deques[n].lock);
+
+    pool->nthreads = threads;
+
+    for (size_t n = 0; n < threads; n++) {
+        pool->workers[n].pool   = pool;
+        pool->workers[n].worker = n;
+
+        if (!_validus_thread_create(&pool->threads[n], &_validus_ws_run, &pool->workers[n]))
+            break;
+
+        pool->started++;
+    }
+
+    if (0 == pool->started) {
+        _validus_ws_free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+bool _validus_ws_submit(validus_ws_pool* pool, void* job)
+{
+    if (!pool || !job)
+        return false;
+
+    /* counted before it is pushed: a worker may take it (and decrement the
+     * count) as soon as it is in the deque. */
+    _validus_mutex_lock(&pool->lock);
+    size_t target = pool->next;
+    pool->next    = (pool->next + 1) % pool->nthreads;
+    pool->queued++;
+    _validus_mutex_unlock(&pool->lock);
+
+    bool pushed = _validus_ws_push(&pool->deques[target], job);
+
+    _validus_mutex_lock(&pool->lock);
+    if (pushed)
+        _validus_cond_signal(&pool->cond);
+    else
+        pool->queued--;
+    _validus_mutex_unlock(&pool->lock);
+
+    return pushed;
+}
+
+void _validus_ws_finish(validus_ws_pool* pool)
+{
+    if (!pool)
+        return;
+
+    _validus_mutex_lock(&pool->lock);
+    pool->closing = true;
+    _validus_cond_broadcast(&pool->cond);
+    _validus_mutex_unlock(&pool->lock);
+
+    for (size_t n = 0; n < pool->started; n++)
+        _validus_thread_join(pool->threads[n]);
+
+    _validus_ws_free(pool);
+}
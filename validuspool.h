@@ -0,0 +1,121 @@
+/**
+ * @file validuspool.h
+ * @brief Internal threading primitives and thread pool used by Validus.
+ *
+ * Thin portable wrappers around POSIX threads and Win32 threads, and a
+ * parallel-for thread pool built upon them.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _VALIDUS_POOL_H_INCLUDED
+# define _VALIDUS_POOL_H_INCLUDED
+
+# include "validusutil.h"
+
+# if !defined(__WIN__)
+#  include <pthread.h>
+# endif
+
+/////////////////////////////// typedefs ///////////////////////////////////////
+
+# if defined(__WIN__)
+typedef HANDLE validus_thread;             /**< A thread. */
+typedef SRWLOCK validus_mutex;             /**< A mutex. */
+typedef CONDITION_VARIABLE validus_cond;   /**< A condition variable. */
+# else
+typedef pthread_t validus_thread;          /**< A thread. */
+typedef pthread_mutex_t validus_mutex;     /**< A mutex. */
+typedef pthread_cond_t validus_cond;       /**< A condition variable. */
+# endif
+
+/** The entry point of a thread. */
+typedef void (*validus_thread_fn)(void* arg);
+
+/**
+ * A unit of work for ::_validus_parallel_for: processes item `idx`, on the
+ * worker numbered `worker` (0 to threads - 1).
+ */
+typedef void (*validus_task_fn)(void* ctx, size_t worker, size_t idx);
+
+/** A unit of work for a ::validus_ws_pool: processes `job` on worker `worker`. */
+typedef void (*validus_job_fn)(void* ctx, size_t worker, void* job);
+
+/**
+ * A work-stealing thread pool: every worker owns a deque of jobs, and takes
+ * jobs from its own deque first (oldest first), then steals from the back of
+ * the other workers' deques when its own is empty.
+ */
+typedef struct validus_ws_pool validus_ws_pool;
+
+///////////////////////////// function exports /////////////////////////////////
+
+# if defined(__cplusplus)
+extern "C" {
+# endif
+
+bool _validus_thread_create(validus_thread* thread, validus_thread_fn fn, void* arg);
+void _validus_thread_join(validus_thread thread);
+
+void _validus_mutex_init(validus_mutex* mutex);
+void _validus_mutex_destroy(validus_mutex* mutex);
+void _validus_mutex_lock(validus_mutex* mutex);
+void _validus_mutex_unlock(validus_mutex* mutex);
+
+void _validus_cond_init(validus_cond* cond);
+void _validus_cond_destroy(validus_cond* cond);
+void _validus_cond_wait(validus_cond* cond, validus_mutex* mutex);
+void _validus_cond_signal(validus_cond* cond);
+void _validus_cond_broadcast(validus_cond* cond);
+
+/**
+ * Runs `fn` for every index in [0, count) on a pool of `threads` workers.
+ * Items are handed out dynamically, so uneven item costs balance out. Returns
+ * once every item has been processed.
+ *
+ * @param threads Number of workers; 0 selects ::validus_cpu_count. Never more
+ *                workers than items are started.
+ * @returns bool `false` if `fn` is NULL or memory could not be allocated (in
+ *               which case no items are processed), `true` otherwise. The
+ *               calling thread is always one of the workers, so all items are
+ *               processed even if additional threads fail to start.
+ */
+bool _validus_parallel_for(size_t threads, size_t count, validus_task_fn fn, void* ctx);
+
+/**
+ * Starts a work-stealing pool of `threads` workers (0 selects
+ * ::validus_cpu_count), which run `fn` for each submitted job. Returns NULL if
+ * no worker could be started.
+ */
+validus_ws_pool* _validus_ws_create(size_t threads, validus_job_fn fn, void* ctx);
+
+/** Submits a job; jobs are dealt to the workers' deques in turn. */
+bool _validus_ws_submit(validus_ws_pool* pool, void* job);
+
+/** Waits for every submitted job to complete, then stops and frees the pool. */
+void _validus_ws_finish(validus_ws_pool* pool);
+
+# if defined(__cplusplus)
+}
+# endif
+
+#endif /* !_VALIDUS_POOL_H_INCLUDED */
@@ -0,0 +1,290 @@
+/**
+ * @file validusranges.c
+ * @brief Implementation of per-range fingerprints (signatures) of files.
+ *
+ * Splits the input into fixed-size leaves, fingerprints the leaves in parallel,
+ * and combines the leaf fingerprints into a single root fingerprint.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusio.h"
+#include "validuspool.h"
+
+typedef struct {
+    validus_fd fd;
+    uint64_t size;
+    uint64_t range_size;
+    validus_state* out;
+    bool* failed; /**< One failure flag per range. */
+} validus_ranges;
+
+/** Hashes range `idx`, reading it with pread in pieces of (at most)
+ * VALIDUS_RANGES_READSIZE octets into the worker thread's read buffer. */
+static void _validus_ranges_task(void* ctx, size_t worker, size_t idx)
+{
+    validus_ranges* ranges = (validus_ranges*)ctx;
+    uint64_t off           = (uint64_t)idx * ranges->range_size;
+    uint64_t left          = ranges->size - off < ranges->range_size
+        ? ranges->size - off : ranges->range_size;
+    size_t chunk           = left < VALIDUS_RANGES_READSIZE ? (size_t)left : VALIDUS_RANGES_READSIZE;
+    (void)worker;
+
+    validus_octet* buf = _validus_io_buffer(chunk, 0U);
+    if (!buf) {
+        ranges->failed[idx] = true;
+        return;
+    }
+
+    validus_stream stream;
+    validus_stream_init(&stream);
+
+    while (left > 0) {
+        size_t len = left < chunk ? (size_t)left : chunk;
+        size_t got = 0;
+
+        if (!_validus_file_pread(ranges->fd, buf, len, off, &got) || got != len) {
+            ranges->failed[idx] = true;
+            return;
+        }
+
+        validus_stream_write(&stream, buf, len);
+        off  += len;
+        left -= len;
+    }
+
+    validus_stream_finalize(&stream);
+    ranges->out[idx] = stream.state;
+}
+
+size_t validus_range_count(uint64_t size, uint64_t range_size)
+{
+    if (0ULL == range_size)
+        return 0;
+
+    uint64_t count = size / range_size + (size % range_size ? 1ULL : 0ULL);
+    return count > (uint64_t)(SIZE_MAX / sizeof(validus_state)) ? 0 : (size_t)count;
+}
+
+bool _validus_hash_ranges(validus_fd fd, uint64_t size, uint64_t range_size,
+    size_t threads, validus_state* out)
+{
+    size_t count = validus_range_count(size, range_size);
+    if (0 == count)
+        return 0ULL == size && 0ULL != range_size;
+
+    validus_ranges ranges = {0};
+    ranges.fd             = fd;
+    ranges.size           = size;
+    ranges.range_size     = range_size;
+    ranges.out            = out;
+    ranges.failed         = calloc(count, sizeof(bool));
+
+    if (!ranges.failed) {
+        fprintf(stderr, "failed to allocate memory for %zu ranges: %d\n", count, errno);
+        return false;
+    }
+
+    bool retval = _validus_parallel_for(threads, count, &_validus_ranges_task, &ranges);
+
+    for (size_t n = 0; retval && n < count; n++)
+        retval = !ranges.failed[n];
+
+    free(ranges.failed);
+
+    return retval;
+}
+
+bool validus_hash_ranges(validus_signature* sig, const char* file, uint64_t range_size,
+    size_t threads)
+{
+    if (!sig || (!file || !*file) || 0ULL == range_size)
+        return false;
+
+    memset(sig, 0, sizeof(validus_signature));
+
+    validus_fd fd = _validus_file_open(file, 0U);
+    if (VALIDUS_INVALID_FD == fd)
+        return false;
+
+    uint64_t size = 0;
+    bool regular  = false;
+    bool retval   = false;
+
+    if (!_validus_file_stat(fd, &size, &regular))
+        goto _cleanup;
+
+    /* ranges are read at their offsets, so the file must be seekable. */
+    if (!regular) {
+        fprintf(stderr, "'%s' is not a regular file\n", file);
+        goto _cleanup;
+    }
+
+    size_t count = validus_range_count(size, range_size);
+    if (0 == count && size > 0) {
+        fprintf(stderr, "too many ranges of %" PRIu64 " octets in '%s'\n", range_size, file);
+        goto _cleanup;
+    }
+
+    sig->size       = size;
+    sig->range_size = range_size;
+    sig->count      = count;
+    sig->ranges     = calloc(count > 0 ? count : 1, sizeof(validus_state));
+
+    if (!sig->ranges) {
+        fprintf(stderr, "failed to allocate memory for %zu ranges: %d\n", count, errno);
+        goto _cleanup;
+    }
+
+    retval = _validus_hash_ranges(fd, size, range_size, threads, sig->ranges);
+    if (!retval)
+        fprintf(stderr, "failed to read from file '%s'\n", file);
+
+_cleanup:
+    _validus_file_close(fd);
+
+    if (!retval)
+        validus_signature_free(sig);
+
+    return retval;
+}
+
+void validus_signature_free(validus_signature* sig)
+{
+    if (!sig)
+        return;
+
+    free(sig->ranges);
+    memset(sig, 0, sizeof(validus_signature));
+}
+
+bool validus_signature_write(const validus_signature* sig, FILE* out)
+{
+    if (!sig || !out || (sig->count > 0 && !sig->ranges))
+        return false;
+
+    validus_octet hdr[VALIDUS_SIGNATURE_HEADER] = {'V', 'L', 'D', 'R', VALIDUS_SIGNATURE_VERSION};
+    _validus_store64(hdr + 8,  sig->size);
+    _validus_store64(hdr + 16, sig->range_size);
+    _validus_store64(hdr + 24, (uint64_t)sig->count);
+
+    if (1 != fwrite(hdr, sizeof(hdr), 1, out))
+        return false;
+
+    for (size_t n = 0; n < sig->count; n++) {
+        const validus_state* state = &sig->ranges[n];
+        validus_octet entry[VALIDUS_SIGNATURE_ENTRY];
+
+        _validus_fp_store(entry, state);
+
+        if (1 != fwrite(entry, sizeof(entry), 1, out))
+            return false;
+    }
+
+    return 0 == fflush(out);
+}
+
+bool validus_signature_read(validus_signature* sig, FILE* in)
+{
+    if (!sig || !in)
+        return false;
+
+    memset(sig, 0, sizeof(validus_signature));
+
+    validus_octet hdr[VALIDUS_SIGNATURE_HEADER];
+    if (1 != fread(hdr, sizeof(hdr), 1, in) || hdr[0] != 'V' || hdr[1] != 'L' ||
+        hdr[2] != 'D' || hdr[3] != 'R' || hdr[4] != VALIDUS_SIGNATURE_VERSION)
+        return false;
+
+    uint64_t size       = _validus_load64(hdr + 8);
+    uint64_t range_size = _validus_load64(hdr + 16);
+    uint64_t count      = _validus_load64(hdr + 24);
+
+    /* the count is implied by the other two; a mismatch is a damaged file. */
+    if (0ULL == range_size || count != (uint64_t)validus_range_count(size, range_size) ||
+        (0ULL == count && size > 0))
+        return false;
+
+    validus_state* ranges = calloc(count > 0 ? (size_t)count : 1, sizeof(validus_state));
+    if (!ranges)
+        return false;
+
+    for (size_t n = 0; n < (size_t)count; n++) {
+        validus_octet entry[VALIDUS_SIGNATURE_ENTRY];
+        if (1 != fread(entry, sizeof(entry), 1, in)) {
+            free(ranges);
+            return false;
+        }
+
+        _validus_fp_load(&ranges[n], entry);
+    }
+
+    sig->size       = size;
+    sig->range_size = range_size;
+    sig->count      = (size_t)count;
+    sig->ranges     = ranges;
+
+    return true;
+}
+
+bool validus_signature_diff(const validus_signature* old_sig, const validus_signature* new_sig,
+    validus_range_fn fn, void* ctx)
+{
+    if (!old_sig || !new_sig || !fn || old_sig->range_size != new_sig->range_size)
+        return false;
+
+    /* runs of changed ranges are reported as one. */
+    uint64_t run = 0, run_len = 0;
+
+    for (size_t n = 0; n < new_sig->count; n++) {
+        uint64_t off = (uint64_t)n * new_sig->range_size;
+        uint64_t len = new_sig->size - off < new_sig->range_size
+            ? new_sig->size - off : new_sig->range_size;
+
+        /* the old range must exist, be as long, and have the same fingerprint
+         * (only f0..f5 are stored in a signature file). */
+        bool same = n < old_sig->count &&
+            (old_sig->size - off < old_sig->range_size
+                ? old_sig->size - off : old_sig->range_size) == len &&
+            old_sig->ranges[n].f0 == new_sig->ranges[n].f0 &&
+            old_sig->ranges[n].f1 == new_sig->ranges[n].f1 &&
+            old_sig->ranges[n].f2 == new_sig->ranges[n].f2 &&
+            old_sig->ranges[n].f3 == new_sig->ranges[n].f3 &&
+            old_sig->ranges[n].f4 == new_sig->ranges[n].f4 &&
+            old_sig->ranges[n].f5 == new_sig->ranges[n].f5;
+
+        if (same) {
+            if (run_len > 0)
+                fn(ctx, run, run_len);
+            run_len = 0;
+        } else {
+            if (0ULL == run_len)
+                run = off;
+            run_len += len;
+        }
+    }
+
+    if (run_len > 0)
+        fn(ctx, run, run_len);
+
+    return true;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file validusrounds.h
+ * @brief The Validus round schedule.
+ *
+ * Lists the 192 rounds of the Validus compression function in order, so that
+ * every kernel (scalar or vectorized) is generated from the same schedule.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _VALIDUS_ROUNDS_H_INCLUDED
+# define _VALIDUS_ROUNDS_H_INCLUDED
+
+/**
+ * Expands to the complete round schedule of the compression function.
+ *
+ * Each round is emitted as `Rn(a, b, c, d, e, f, r1, r2, idx, hcv)`, where `n`
+ * is the stage (0-3) selecting the mixer, `a`-`f` are the working variables in
+ * the order the round consumes them, `r1`/`r2` are the rotation amounts, `idx`
+ * is the index of the message word, and `hcv` is the round constant.
+ */
+# define VALIDUS_ROUNDS(R0, R1, R2, R3) \
+    R0(d, c, b, a, f, e,  2,  3, 47, VALIDUS_0)   \
+    R0(c, b, a, f, e, d,  7,  6, 46, VALIDUS_1)   \
+    R0(b, a, f, e, d, c, 10,  9, 45, VALIDUS_2)   \
+    R0(a, f, e, d, c, b, 15, 12, 44, VALIDUS_3)   \
+    R0(f, e, d, c, b, a, 20, 21, 43, VALIDUS_4)   \
+    R0(e, d, c, b, a, f, 25, 24, 42, VALIDUS_5)   \
+    R0(d, c, b, a, f, e,  2,  3, 41, VALIDUS_6)   \
+    R0(c, b, a, f, e, d,  7,  6, 40, VALIDUS_7)   \
+    R0(b, a, f, e, d, c, 10,  9, 39, VALIDUS_8)   \
+    R0(a, f, e, d, c, b, 15, 12, 38, VALIDUS_9)   \
+    R0(f, e, d, c, b, a, 20, 21, 37, VALIDUS_10)  \
+    R0(e, d, c, b, a, f, 25, 24, 36, VALIDUS_11)  \
+    R0(d, c, b, a, f, e,  2,  3, 35, VALIDUS_12)  \
+    R0(c, b, a, f, e, d,  7,  6, 34, VALIDUS_13)  \
+    R0(b, a, f, e, d, c, 10,  9, 33, VALIDUS_14)  \
+    R0(a, f, e, d, c, b, 15, 12, 32, VALIDUS_15)  \
+    R0(f, e, d, c, b, a, 20, 21, 31, VALIDUS_16)  \
+    R0(e, d, c, b, a, f, 25, 24, 30, VALIDUS_17)  \
+    R0(d, c, b, a, f, e,  2,  3, 29, VALIDUS_18)  \
+    R0(c, b, a, f, e, d,  7,  6, 28, VALIDUS_19)  \
+    R0(b, a, f, e, d, c, 10,  9, 27, VALIDUS_20)  \
+    R0(a, f, e, d, c, b, 15, 12, 26, VALIDUS_21)  \
+    R0(f, e, d, c, b, a, 20, 21, 25, VALIDUS_22)  \
+    R0(e, d, c, b, a, f, 25, 24, 24, VALIDUS_23)  \
+    R0(d, c, b, a, f, e,  2,  3,  0, VALIDUS_24)  \
+    R0(c, b, a, f, e, d,  7,  6,  1, VALIDUS_25)  \
+    R0(b, a, f, e, d, c, 10,  9,  2, VALIDUS_26)  \
+    R0(a, f, e, d, c, b, 15, 12,  3, VALIDUS_27)  \
+    R0(f, e, d, c, b, a, 20, 21,  4, VALIDUS_28)  \
+    R0(e, d, c, b, a, f, 25, 24,  5, VALIDUS_29)  \
+    R0(d, c, b, a, f, e,  2,  3,  6, VALIDUS_30)  \
+    R0(c, b, a, f, e, d,  7,  6,  7, VALIDUS_31)  \
+    R0(b, a, f, e, d, c, 10,  9,  8, VALIDUS_32)  \
+    R0(a, f, e, d, c, b, 15, 12,  9, VALIDUS_33)  \
+    R0(f, e, d, c, b, a, 20, 21, 10, VALIDUS_34)  \
+    R0(e, d, c, b, a, f, 25, 24, 11, VALIDUS_35)  \
+    R0(d, c, b, a, f, e,  2,  3, 12, VALIDUS_36)  \
+    R0(c, b, a, f, e, d,  7,  6, 13, VALIDUS_37)  \
+    R0(b, a, f, e, d, c, 10,  9, 14, VALIDUS_38)  \
+    R0(a, f, e, d, c, b, 15, 12, 15, VALIDUS_39)  \
+    R0(f, e, d, c, b, a, 20, 21, 16, VALIDUS_40)  \
+    R0(e, d, c, b, a, f, 25, 24, 17, VALIDUS_41)  \
+    R0(d, c, b, a, f, e,  2,  3, 18, VALIDUS_42)  \
+    R0(c, b, a, f, e, d,  7,  6, 19, VALIDUS_43)  \
+    R0(b, a, f, e, d, c, 10,  9, 20, VALIDUS_44)  \
+    R0(a, f, e, d, c, b, 15, 12, 21, VALIDUS_45)  \
+    R0(f, e, d, c, b, a, 20, 21, 22, VALIDUS_46)  \
+    R0(e, d, c, b, a, f, 25, 24, 23, VALIDUS_47)  \
+    R1(d, c, b, a, f, e,  5,  4, 22, VALIDUS_48)  \
+    R1(c, b, a, f, e, d, 13, 14, 20, VALIDUS_49)  \
+    R1(b, a, f, e, d, c, 17, 16, 18, VALIDUS_50)  \
+    R1(a, f, e, d, c, b, 22, 19, 23, VALIDUS_51)  \
+    R1(f, e, d, c, b, a, 26, 23, 21, VALIDUS_52)  \
+    R1(e, d, c, b, a, f, 28, 29, 19, VALIDUS_53)  \
+    R1(d, c, b, a, f, e,  5,  4, 16, VALIDUS_54)  \
+    R1(c, b, a, f, e, d, 13, 14, 14, VALIDUS_55)  \
+    R1(b, a, f, e, d, c, 17, 16, 12, VALIDUS_56)  \
+    R1(a, f, e, d, c, b, 22, 19, 17, VALIDUS_57)  \
+    R1(f, e, d, c, b, a, 26, 23, 15, VALIDUS_58)  \
+    R1(e, d, c, b, a, f, 28, 29, 13, VALIDUS_59)  \
+    R1(d, c, b, a, f, e,  5,  4, 10, VALIDUS_60)  \
+    R1(c, b, a, f, e, d, 13, 14,  8, VALIDUS_61)  \
+    R1(b, a, f, e, d, c, 17, 16,  6, VALIDUS_62)  \
+    R1(a, f, e, d, c, b, 22, 19, 11, VALIDUS_63)  \
+    R1(f, e, d, c, b, a, 26, 23,  9, VALIDUS_64)  \
+    R1(e, d, c, b, a, f, 28, 29,  7, VALIDUS_65)  \
+    R1(d, c, b, a, f, e,  5,  4,  4, VALIDUS_66)  \
+    R1(c, b, a, f, e, d, 13, 14,  2, VALIDUS_67)  \
+    R1(b, a, f, e, d, c, 17, 16,  0, VALIDUS_68)  \
+    R1(a, f, e, d, c, b, 22, 19,  5, VALIDUS_69)  \
+    R1(f, e, d, c, b, a, 26, 23,  3, VALIDUS_70)  \
+    R1(e, d, c, b, a, f, 28, 29,  1, VALIDUS_71)  \
+    R1(d, c, b, a, f, e,  5,  4, 25, VALIDUS_72)  \
+    R1(c, b, a, f, e, d, 13, 14, 27, VALIDUS_73)  \
+    R1(b, a, f, e, d, c, 17, 16, 29, VALIDUS_74)  \
+    R1(a, f, e, d, c, b, 22, 19, 24, VALIDUS_75)  \
+    R1(f, e, d, c, b, a, 26, 23, 26, VALIDUS_76)  \
+    R1(e, d, c, b, a, f, 28, 29, 28, VALIDUS_77)  \
+    R1(d, c, b, a, f, e,  5,  4, 31, VALIDUS_78)  \
+    R1(c, b, a, f, e, d, 13, 14, 33, VALIDUS_79)  \
+    R1(b, a, f, e, d, c, 17, 16, 35, VALIDUS_80)  \
+    R1(a, f, e, d, c, b, 22, 19, 30, VALIDUS_81)  \
+    R1(f, e, d, c, b, a, 26, 23, 32, VALIDUS_82)  \
+    R1(e, d, c, b, a, f, 28, 29, 34, VALIDUS_83)  \
+    R1(d, c, b, a, f, e,  5,  4, 37, VALIDUS_84)  \
+    R1(c, b, a, f, e, d, 13, 14, 39, VALIDUS_85)  \
+    R1(b, a, f, e, d, c, 17, 16, 41, VALIDUS_86)  \
+    R1(a, f, e, d, c, b, 22, 19, 36, VALIDUS_87)  \
+    R1(f, e, d, c, b, a, 26, 23, 38, VALIDUS_88)  \
+    R1(e, d, c, b, a, f, 28, 29, 40, VALIDUS_89)  \
+    R1(d, c, b, a, f, e,  5,  4, 43, VALIDUS_90)  \
+    R1(c, b, a, f, e, d, 13, 14, 45, VALIDUS_91)  \
+    R1(b, a, f, e, d, c, 17, 16, 47, VALIDUS_92)  \
+    R1(a, f, e, d, c, b, 22, 19, 42, VALIDUS_93)  \
+    R1(f, e, d, c, b, a, 26, 23, 44, VALIDUS_94)  \
+    R1(e, d, c, b, a, f, 28, 29, 46, VALIDUS_95)  \
+    R2(d, c, b, a, f, e,  3,  2,  1, VALIDUS_96)  \
+    R2(c, b, a, f, e, d,  6,  7,  0, VALIDUS_97)  \
+    R2(b, a, f, e, d, c,  9, 10,  3, VALIDUS_98)  \
+    R2(a, f, e, d, c, b, 12, 15,  2, VALIDUS_99)  \
+    R2(f, e, d, c, b, a, 21, 20,  5, VALIDUS_100) \
+    R2(e, d, c, b, a, f, 24, 25,  4, VALIDUS_101) \
+    R2(d, c, b, a, f, e,  3,  2,  7, VALIDUS_102) \
+    R2(c, b, a, f, e, d,  6,  7,  6, VALIDUS_103) \
+    R2(b, a, f, e, d, c,  9, 10,  9, VALIDUS_104) \
+    R2(a, f, e, d, c, b, 12, 15,  8, VALIDUS_105) \
+    R2(f, e, d, c, b, a, 21, 20, 11, VALIDUS_106) \
+    R2(e, d, c, b, a, f, 24, 25, 10, VALIDUS_107) \
+    R2(d, c, b, a, f, e,  3,  2, 13, VALIDUS_108) \
+    R2(c, b, a, f, e, d,  6,  7, 12, VALIDUS_109) \
+    R2(b, a, f, e, d, c,  9, 10, 15, VALIDUS_110) \
+    R2(a, f, e, d, c, b, 12, 15, 14, VALIDUS_111) \
+    R2(f, e, d, c, b, a, 21, 20, 17, VALIDUS_112) \
+    R2(e, d, c, b, a, f, 24, 25, 16, VALIDUS_113) \
+    R2(d, c, b, a, f, e,  3,  2, 19, VALIDUS_114) \
+    R2(c, b, a, f, e, d,  6,  7, 18, VALIDUS_115) \
+    R2(b, a, f, e, d, c,  9, 10, 21, VALIDUS_116) \
+    R2(a, f, e, d, c, b, 12, 15, 20, VALIDUS_117) \
+    R2(f, e, d, c, b, a, 21, 20, 23, VALIDUS_118) \
+    R2(e, d, c, b, a, f, 24, 25, 22, VALIDUS_119) \
+    R2(d, c, b, a, f, e,  3,  2, 46, VALIDUS_120) \
+    R2(c, b, a, f, e, d,  6,  7, 47, VALIDUS_121) \
+    R2(b, a, f, e, d, c,  9, 10, 44, VALIDUS_122) \
+    R2(a, f, e, d, c, b, 12, 15, 45, VALIDUS_123) \
+    R2(f, e, d, c, b, a, 21, 20, 42, VALIDUS_124) \
+    R2(e, d, c, b, a, f, 24, 25, 43, VALIDUS_125) \
+    R2(d, c, b, a, f, e,  3,  2, 40, VALIDUS_126) \
+    R2(c, b, a, f, e, d,  6,  7, 41, VALIDUS_127) \
+    R2(b, a, f, e, d, c,  9, 10, 38, VALIDUS_128) \
+    R2(a, f, e, d, c, b, 12, 15, 39, VALIDUS_129) \
+    R2(f, e, d, c, b, a, 21, 20, 36, VALIDUS_130) \
+    R2(e, d, c, b, a, f, 24, 25, 37, VALIDUS_131) \
+    R2(d, c, b, a, f, e,  3,  2, 34, VALIDUS_132) \
+    R2(c, b, a, f, e, d,  6,  7, 35, VALIDUS_133) \
+    R2(b, a, f, e, d, c,  9, 10, 32, VALIDUS_134) \
+    R2(a, f, e, d, c, b, 12, 15, 33, VALIDUS_135) \
+    R2(f, e, d, c, b, a, 21, 20, 30, VALIDUS_136) \
+    R2(e, d, c, b, a, f, 24, 25, 31, VALIDUS_137) \
+    R2(d, c, b, a, f, e,  3,  2, 28, VALIDUS_138) \
+    R2(c, b, a, f, e, d,  6,  7, 29, VALIDUS_139) \
+    R2(b, a, f, e, d, c,  9, 10, 26, VALIDUS_140) \
+    R2(a, f, e, d, c, b, 12, 15, 27, VALIDUS_141) \
+    R2(f, e, d, c, b, a, 21, 20, 24, VALIDUS_142) \
+    R2(e, d, c, b, a, f, 24, 25, 25, VALIDUS_143) \
+    R3(d, c, b, a, f, e,  4,  5, 24, VALIDUS_144) \
+    R3(c, b, a, f, e, d, 14, 13, 26, VALIDUS_145) \
+    R3(b, a, f, e, d, c, 16, 17, 28, VALIDUS_146) \
+    R3(a, f, e, d, c, b, 19, 22, 25, VALIDUS_147) \
+    R3(f, e, d, c, b, a, 23, 26, 27, VALIDUS_148) \
+    R3(e, d, c, b, a, f, 29, 28, 29, VALIDUS_149) \
+    R3(d, c, b, a, f, e,  4,  5, 30, VALIDUS_150) \
+    R3(c, b, a, f, e, d, 14, 13, 32, VALIDUS_151) \
+    R3(b, a, f, e, d, c, 16, 17, 34, VALIDUS_152) \
+    R3(a, f, e, d, c, b, 19, 22, 31, VALIDUS_153) \
+    R3(f, e, d, c, b, a, 23, 26, 33, VALIDUS_154) \
+    R3(e, d, c, b, a, f, 29, 28, 35, VALIDUS_155) \
+    R3(d, c, b, a, f, e,  4,  5, 36, VALIDUS_156) \
+    R3(c, b, a, f, e, d, 14, 13, 38, VALIDUS_157) \
+    R3(b, a, f, e, d, c, 16, 17, 40, VALIDUS_158) \
+    R3(a, f, e, d, c, b, 19, 22, 37, VALIDUS_159) \
+    R3(f, e, d, c, b, a, 23, 26, 39, VALIDUS_160) \
+    R3(e, d, c, b, a, f, 29, 28, 41, VALIDUS_161) \
+    R3(d, c, b, a, f, e,  4,  5, 42, VALIDUS_162) \
+    R3(c, b, a, f, e, d, 14, 13, 44, VALIDUS_163) \
+    R3(b, a, f, e, d, c, 16, 17, 46, VALIDUS_164) \
+    R3(a, f, e, d, c, b, 19, 22, 43, VALIDUS_165) \
+    R3(f, e, d, c, b, a, 23, 26, 45, VALIDUS_166) \
+    R3(e, d, c, b, a, f, 29, 28, 47, VALIDUS_167) \
+    R3(d, c, b, a, f, e,  4,  5, 23, VALIDUS_168) \
+    R3(c, b, a, f, e, d, 14, 13, 21, VALIDUS_169) \
+    R3(b, a, f, e, d, c, 16, 17, 19, VALIDUS_170) \
+    R3(a, f, e, d, c, b, 19, 22, 22, VALIDUS_171) \
+    R3(f, e, d, c, b, a, 23, 26, 20, VALIDUS_172) \
+    R3(e, d, c, b, a, f, 29, 28, 18, VALIDUS_173) \
+    R3(d, c, b, a, f, e,  4,  5, 17, VALIDUS_174) \
+    R3(c, b, a, f, e, d, 14, 13, 15, VALIDUS_175) \
+    R3(b, a, f, e, d, c, 16, 17, 13, VALIDUS_176) \
+    R3(a, f, e, d, c, b, 19, 22, 16, VALIDUS_177) \
+    R3(f, e, d, c, b, a, 23, 26, 14, VALIDUS_178) \
+    R3(e, d, c, b, a, f, 29, 28, 12, VALIDUS_179) \
+    R3(d, c, b, a, f, e,  4,  5, 11, VALIDUS_180) \
+    R3(c, b, a, f, e, d, 14, 13,  9, VALIDUS_181) \
+    R3(b, a, f, e, d, c, 16, 17,  7, VALIDUS_182) \
+    R3(a, f, e, d, c, b, 19, 22, 10, VALIDUS_183) \
+    R3(f, e, d, c, b, a, 23, 26,  8, VALIDUS_184) \
+    R3(e, d, c, b, a, f, 29, 28,  6, VALIDUS_185) \
+    R3(d, c, b, a, f, e,  4,  5,  5, VALIDUS_186) \
+    R3(c, b, a, f, e, d, 14, 13,  3, VALIDUS_187) \
+    R3(b, a, f, e, d, c, 16, 17,  1, VALIDUS_188) \
+    R3(a, f, e, d, c, b, 19, 22,  4, VALIDUS_189) \
+    R3(f, e, d, c, b, a, 23, 26,  2, VALIDUS_190) \
+    R3(e, d, c, b, a, f, 29, 28,  0, VALIDUS_191)
+
+#endif /* !_VALIDUS_ROUNDS_H_INCLUDED */
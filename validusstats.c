@@ -0,0 +1,191 @@
+/**
+ * @file validusstats.c
+ * @brief Implementation of the hot-path counters.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusstats.h"
+#include "validusutil.h"
+
+#if defined(VALIDUS_STATS)
+
+# if !defined(__WIN__)
+#  include <pthread.h>
+# endif
+
+_Thread_local validus_stats_tls* _validus_stats_self = NULL;
+
+/** Every live thread's counters, and the totals of threads that have exited. */
+static validus_stats_tls* _validus_stats_threads = NULL;
+static uint64_t _validus_stats_retired[VALIDUS_STAT_COUNT];
+
+# if defined(__WIN__)
+static SRWLOCK _validus_stats_lock    = SRWLOCK_INIT;
+static INIT_ONCE _validus_stats_once  = INIT_ONCE_STATIC_INIT;
+static DWORD _validus_stats_key       = FLS_OUT_OF_INDEXES;
+#  define _VALIDUS_STATS_LOCK()   AcquireSRWLockExclusive(&_validus_stats_lock)
+#  define _VALIDUS_STATS_UNLOCK() ReleaseSRWLockExclusive(&_validus_stats_lock)
+# else
+static pthread_mutex_t _validus_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t _validus_stats_once  = PTHREAD_ONCE_INIT;
+static pthread_key_t _validus_stats_key;
+static bool _validus_stats_have_key        = false;
+#  define _VALIDUS_STATS_LOCK()   (void)pthread_mutex_lock(&_validus_stats_lock)
+#  define _VALIDUS_STATS_UNLOCK() (void)pthread_mutex_unlock(&_validus_stats_lock)
+# endif
+
+/**
+ * Folds an exiting thread's counters into the retired totals. Should a later
+ * destructor on the same thread count anything, its counters are registered
+ * again, and retired on the next destructor pass (or kept, and leaked, if
+ * there is none).
+ */
+# if defined(__WIN__)
+static void WINAPI _validus_stats_retire(void* arg)
+# else
+static void _validus_stats_retire(void* arg)
+# endif
+{
+    validus_stats_tls* self = (validus_stats_tls*)arg;
+    if (!self)
+        return;
+
+    _VALIDUS_STATS_LOCK();
+
+    for (validus_stats_tls** link = &_validus_stats_threads; *link; link = &(*link)->next) {
+        if (*link == self) {
+            *link = self->next;
+            break;
+        }
+    }
+
+    for (size_t n = 0; n < VALIDUS_STAT_COUNT; n++)
+        _validus_stats_retired[n] += atomic_load_explicit(&self->v[n], memory_order_relaxed);
+
+    _VALIDUS_STATS_UNLOCK();
+
+    /* destructors run on the exiting thread, in no particular order. */
+    if (_validus_stats_self == self)
+        _validus_stats_self = NULL;
+
+    free(self);
+}
+
+# if defined(__WIN__)
+static BOOL CALLBACK _validus_stats_init(PINIT_ONCE once, PVOID param, PVOID* ctx)
+{
+    (void)once;
+    (void)param;
+    (void)ctx;
+    _validus_stats_key = FlsAlloc(&_validus_stats_retire);
+    return TRUE;
+}
+# else
+static void _validus_stats_init(void)
+{
+    _validus_stats_have_key = 0 == pthread_key_create(&_validus_stats_key, &_validus_stats_retire);
+}
+# endif
+
+validus_stats_tls* _validus_stats_register(void)
+{
+    validus_stats_tls* self = calloc(1, sizeof(validus_stats_tls));
+    if (!self)
+        return NULL;
+
+    for (size_t n = 0; n < VALIDUS_STAT_COUNT; n++)
+        atomic_init(&self->v[n], 0ULL);
+
+    /* without a destructor, the counters stay registered (and still count
+     * towards validus_stats_get) after the thread exits, and are leaked. */
+# if defined(__WIN__)
+    (void)InitOnceExecuteOnce(&_validus_stats_once, &_validus_stats_init, NULL, NULL);
+    if (FLS_OUT_OF_INDEXES != _validus_stats_key)
+        (void)FlsSetValue(_validus_stats_key, self);
+# else
+    (void)pthread_once(&_validus_stats_once, &_validus_stats_init);
+    if (_validus_stats_have_key)
+        (void)pthread_setspecific(_validus_stats_key, self);
+# endif
+
+    _VALIDUS_STATS_LOCK();
+    self->next             = _validus_stats_threads;
+    _validus_stats_threads = self;
+    _VALIDUS_STATS_UNLOCK();
+
+    _validus_stats_self = self;
+    return self;
+}
+
+uint64_t _validus_stats_now(void)
+{
+# if defined(__WIN__)
+    LARGE_INTEGER freq, now;
+    (void)QueryPerformanceFrequency(&freq);
+    (void)QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+# else
+    struct timespec ts;
+    if (0 != clock_gettime(CLOCK_MONOTONIC, &ts))
+        return 0ULL;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+# endif
+}
+
+#endif /* VALIDUS_STATS */
+
+bool validus_stats_get(validus_stats* stats)
+{
+    if (!stats)
+        return false;
+
+    memset(stats, 0, sizeof(validus_stats));
+
+#if defined(VALIDUS_STATS)
+    uint64_t totals[VALIDUS_STAT_COUNT];
+
+    _VALIDUS_STATS_LOCK();
+
+    for (size_t n = 0; n < VALIDUS_STAT_COUNT; n++)
+        totals[n] = _validus_stats_retired[n];
+
+    for (validus_stats_tls* t = _validus_stats_threads; t; t = t->next) {
+        for (size_t n = 0; n < VALIDUS_STAT_COUNT; n++)
+            totals[n] += atomic_load_explicit(&t->v[n], memory_order_relaxed);
+    }
+
+    _VALIDUS_STATS_UNLOCK();
+
+    stats->bytes        = totals[VALIDUS_STAT_BYTES];
+    stats->full_blocks  = totals[VALIDUS_STAT_FULL_BLOCKS];
+    stats->padded_tails = totals[VALIDUS_STAT_PADDED_TAILS];
+    stats->unaligned    = totals[VALIDUS_STAT_UNALIGNED];
+    stats->finalizes    = totals[VALIDUS_STAT_FINALIZES];
+    stats->io_ns        = totals[VALIDUS_STAT_IO_NS];
+    stats->compute_ns   = totals[VALIDUS_STAT_COMPUTE_NS];
+
+    return true;
+#else
+    return false;
+#endif
+}
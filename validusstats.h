@@ -0,0 +1,124 @@
+/**
+ * @file validusstats.h
+ * @brief Internal hot-path counters (compiled in with VALIDUS_STATS).
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _VALIDUS_STATS_H_INCLUDED
+# define _VALIDUS_STATS_H_INCLUDED
+
+# include "validus.h"
+
+/////////////////////////////// typedefs ///////////////////////////////////////
+
+/** The counters; see ::validus_stats for their meaning. */
+typedef enum {
+    VALIDUS_STAT_BYTES = 0,
+    VALIDUS_STAT_FULL_BLOCKS,
+    VALIDUS_STAT_PADDED_TAILS,
+    VALIDUS_STAT_UNALIGNED,
+    VALIDUS_STAT_FINALIZES,
+    VALIDUS_STAT_IO_NS,
+    VALIDUS_STAT_COMPUTE_NS,
+    VALIDUS_STAT_COUNT
+} validus_stat;
+
+# if defined(VALIDUS_STATS)
+#  include <stdatomic.h>
+
+/**
+ * One thread's counters. Only the owning thread writes them; relaxed atomic
+ * loads and stores (not read-modify-writes) let ::validus_stats_get read them
+ * from any thread without a data race, at the cost of plain moves.
+ */
+typedef struct validus_stats_tls {
+    _Atomic uint64_t v[VALIDUS_STAT_COUNT];
+    struct validus_stats_tls* next;
+} validus_stats_tls;
+
+extern _Thread_local validus_stats_tls* _validus_stats_self;
+
+# endif
+
+///////////////////////////// function exports /////////////////////////////////
+
+# if defined(__cplusplus)
+extern "C" {
+# endif
+
+# if defined(VALIDUS_STATS)
+
+/** Allocates and registers the calling thread's counters. */
+validus_stats_tls* _validus_stats_register(void);
+
+/** Returns a monotonic time stamp, in nanoseconds. */
+uint64_t _validus_stats_now(void);
+
+static inline void _validus_stat_add(validus_stat stat, uint64_t n)
+{
+    validus_stats_tls* self = _validus_stats_self;
+    if (!self && !(self = _validus_stats_register()))
+        return;
+
+    atomic_store_explicit(&self->v[stat],
+        atomic_load_explicit(&self->v[stat], memory_order_relaxed) + n,
+        memory_order_relaxed);
+}
+
+static inline uint64_t _validus_stat_value(validus_stat stat)
+{
+    validus_stats_tls* self = _validus_stats_self;
+    return self ? atomic_load_explicit(&self->v[stat], memory_order_relaxed) : 0ULL;
+}
+
+/** Adds `n` to the calling thread's counter `stat`. */
+#  define VALIDUS_STAT_ADD(stat, n) _validus_stat_add((stat), (uint64_t)(n))
+
+/** The calling thread's counter `stat`. */
+#  define VALIDUS_STAT_VALUE(stat) _validus_stat_value(stat)
+
+/** A time stamp for the timing counters. */
+#  define VALIDUS_STAT_NOW() _validus_stats_now()
+
+/** Executes `stmt`, adding the nanoseconds it took to counter `stat`. */
+#  define VALIDUS_STAT_TIMED(stat, stmt) \
+    do { \
+        uint64_t _validus_t0 = _validus_stats_now(); \
+        stmt; \
+        _validus_stat_add((stat), _validus_stats_now() - _validus_t0); \
+    } while (0)
+
+# else /* !VALIDUS_STATS */
+
+#  define VALIDUS_STAT_ADD(stat, n)      ((void)(n))
+#  define VALIDUS_STAT_VALUE(stat)       0ULL
+#  define VALIDUS_STAT_NOW()             0ULL
+#  define VALIDUS_STAT_TIMED(stat, stmt) do { stmt; } while (0)
+
+# endif /* VALIDUS_STATS */
+
+# if defined(__cplusplus)
+}
+# endif
+
+#endif /* !_VALIDUS_STATS_H_INCLUDED */
@@ -0,0 +1,181 @@
+/**
+ * @file validustree.c
+ * @brief Implementation of the Validus tree hashing mode.
+ *
+ * Splits the input into fixed-size leaves, fingerprints the leaves in parallel,
+ * and combines the leaf fingerprints into a single root fingerprint.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusio.h"
+#include "validuspool.h"
+
+/** XORed into the first word of the initial state of the root ("TREE"), so a
+ * root fingerprint is never that of its input hashed as a plain message. */
+#define VALIDUS_TREE_ROOT_TAG 0x54524545U
+
+typedef struct {
+    const validus_octet* mem; /**< The input, when hashing memory. */
+    validus_fd fd;            /**< The input, when hashing a file. */
+    uint64_t len;             /**< Length of the input, in octets. */
+    validus_state* leaves;    /**< One fingerprint per leaf. */
+    bool* failed;             /**< One failure flag per leaf. */
+    validus_octet** bufs;     /**< One leaf-sized read buffer per worker. */
+} validus_tree;
+
+static void _validus_tree_leaf(void* ctx, size_t worker, size_t idx)
+{
+    validus_tree* tree = (validus_tree*)ctx;
+    uint64_t off       = (uint64_t)idx * VALIDUS_TREE_LEAFSIZE;
+    size_t len         = (size_t)((tree->len - off) < VALIDUS_TREE_LEAFSIZE
+        ? (tree->len - off) : VALIDUS_TREE_LEAFSIZE);
+    const validus_octet* data = NULL;
+
+    if (tree->mem) {
+        data = tree->mem + off;
+    } else {
+        if (!tree->bufs[worker]) {
+            tree->bufs[worker] = malloc(VALIDUS_TREE_LEAFSIZE);
+            if (!tree->bufs[worker]) {
+                fprintf(stderr, "failed to allocate %lu octets of heap memory: %d\n",
+                    VALIDUS_TREE_LEAFSIZE, errno);
+                tree->failed[idx] = true;
+                return;
+            }
+        }
+
+        size_t got = 0;
+        if (!_validus_file_pread(tree->fd, tree->bufs[worker], len, off, &got) || got != len) {
+            tree->failed[idx] = true;
+            return;
+        }
+
+        data = tree->bufs[worker];
+    }
+
+    validus_init(&tree->leaves[idx]);
+    validus_append(&tree->leaves[idx], data, len);
+    validus_finalize(&tree->leaves[idx]);
+}
+
+/**
+ * Hashes every leaf of `tree` on `threads` workers, then computes the root:
+ * the fingerprint of the concatenated leaf fingerprints (little-endian words),
+ * followed by the input length and the leaf size as little-endian 64-bit values,
+ * starting from the initial state tagged with VALIDUS_TREE_ROOT_TAG.
+ */
+static bool _validus_tree_hash(validus_state* state, validus_tree* tree,
+    size_t threads)
+{
+    size_t count = (size_t)((tree->len + VALIDUS_TREE_LEAFSIZE - 1) / VALIDUS_TREE_LEAFSIZE);
+
+    if (threads == 0)
+        threads = validus_cpu_count();
+
+    if (threads > count)
+        threads = count > 0 ? count : 1;
+
+    size_t rootlen        = (count * VALIDUS_FP_OCTETS) + (2 * sizeof(uint64_t));
+    validus_octet* root   = calloc(rootlen, sizeof(validus_octet));
+    tree->leaves          = calloc(count > 0 ? count : 1, sizeof(validus_state));
+    tree->failed          = calloc(count > 0 ? count : 1, sizeof(bool));
+    tree->bufs            = calloc(threads, sizeof(validus_octet*));
+    bool retval           = false;
+
+    if (!root || !tree->leaves || !tree->failed || !tree->bufs) {
+        fprintf(stderr, "failed to allocate memory for %zu leaves: %d\n", count, errno);
+        goto _cleanup;
+    }
+
+    if (!_validus_parallel_for(threads, count, &_validus_tree_leaf, tree))
+        goto _cleanup;
+
+    validus_octet* out = root;
+    for (size_t n = 0; n < count; n++) {
+        if (tree->failed[n])
+            goto _cleanup;
+
+        _validus_fp_store(out, &tree->leaves[n]);
+        out += VALIDUS_FP_OCTETS;
+    }
+
+    _validus_store64(out,     tree->len);
+    _validus_store64(out + 8, (uint64_t)VALIDUS_TREE_LEAFSIZE);
+
+    validus_init(state);
+    state->f0 ^= VALIDUS_TREE_ROOT_TAG;
+    validus_append(state, root, rootlen);
+    validus_finalize(state);
+    retval = true;
+
+_cleanup:
+    if (tree->bufs) {
+        for (size_t n = 0; n < threads; n++)
+            free(tree->bufs[n]);
+    }
+
+    free(tree->bufs);
+    free(tree->failed);
+    free(tree->leaves);
+    free(root);
+
+    return retval;
+}
+
+bool validus_tree_hash_mem(validus_state* state, const void* mem, size_t len,
+    size_t threads)
+{
+    if (!state || (!mem && len > 0))
+        return false;
+
+    validus_tree tree = {0};
+    tree.mem = mem ? (const validus_octet*)mem : (const validus_octet*)"";
+    tree.len = len;
+
+    return _validus_tree_hash(state, &tree, threads);
+}
+
+bool validus_tree_hash_file(validus_state* state, const char* file, size_t threads)
+{
+    if (!state || (!file || !*file))
+        return false;
+
+    validus_tree tree = {0};
+    tree.fd = _validus_file_open(file, 0U);
+    if (VALIDUS_INVALID_FD == tree.fd)
+        return false;
+
+    bool retval  = false;
+    bool regular = false;
+
+    /* leaves are read at their offsets, so the file must be seekable. */
+    if (_validus_file_stat(tree.fd, &tree.len, &regular)) {
+        if (regular)
+            retval = _validus_tree_hash(state, &tree, threads);
+        else
+            fprintf(stderr, "'%s' is not a regular file\n", file);
+    }
+
+    _validus_file_close(tree.fd);
+    return retval;
+}
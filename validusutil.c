@@ -26,77 +26,401 @@
  * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
-#include "validusutil.h"
+#include "validusio.h"
+#include "validusstats.h"
 
-bool validus_hash_string(validus_state* state, const char* string)
+bool validus_hash_file(validus_state* state, const char* file)
 {
-    if (!state || !string)
+    return validus_hash_file_ex(state, file, 0U);
+}
+
+/**
+ * Hashes a regular file of `size` octets through memory mappings, and leaves
+ * the file pointer where it stopped (as reading it would). Returns false
+ * without consuming any input if the file could not be mapped at all; if a
+ * later window cannot be mapped, the rest of the file is read instead. The
+ * file pointer must be at the start of the file.
+ */
+static bool _validus_hash_mapped(validus_stream* stream, validus_fd fd,
+    uint64_t size, uint32_t flags, bool* failed)
+{
+    uint64_t off = 0;
+
+    while (off < size) {
+        size_t len = (size_t)((size - off) < VALIDUS_MMAP_WINDOW
+            ? (size - off) : VALIDUS_MMAP_WINDOW);
+
+        const void* map = _validus_file_map(fd, off, len, flags);
+        if (!map)
+            break;
+
+        VALIDUS_STAT_TIMED(VALIDUS_STAT_COMPUTE_NS, validus_stream_write(stream, map, len));
+        _validus_file_unmap(map, len);
+        off += len;
+    }
+
+    if (off == 0)
         return false;
 
-    validus_init(state);
-    validus_append(state, string, strnlen(string, VALIDUS_MAX_STRING));
-    validus_finalize(state);
+    if (off < size) {
+        validus_octet* buf = _validus_io_buffer(VALIDUS_FILE_BLOCKSIZE, flags);
+        if (!buf) {
+            *failed = true;
+            return true;
+        }
+
+        while (off < size) {
+            size_t got = 0;
+            if (!_validus_file_pread(fd, buf, VALIDUS_FILE_BLOCKSIZE, off, &got)) {
+                *failed = true;
+                break;
+            }
+            if (0 == got)
+                break;
+            VALIDUS_STAT_TIMED(VALIDUS_STAT_COMPUTE_NS, validus_stream_write(stream, buf, got));
+            off += got;
+        }
+    }
 
+    (void)_validus_file_seek(fd, off);
     return true;
 }
 
-bool validus_hash_mem(validus_state* state, const void* mem, size_t len)
+/**
+ * Hashes a regular file of `size` octets that has holes, from `pos` (its file
+ * pointer) on: the extents of data are read into `buf` (`blocksize` octets),
+ * and the holes are hashed from a zero page, without reading them. Leaves the
+ * file pointer where it stopped. Returns false without consuming any input if
+ * the rest of the file has no holes, or they cannot be found.
+ */
+static bool _validus_hash_sparse(validus_stream* stream, validus_fd fd, uint64_t pos,
+    uint64_t size, validus_octet* buf, size_t blocksize, uint32_t flags, bool* failed)
 {
-    if (!state || !mem || len == 0)
+    static const validus_octet zeros[VALIDUS_IO_ALIGN] = {0};
+
+    uint64_t data = 0, hole = 0;
+    if (!_validus_file_extent(fd, pos, size, &data, &hole) || (pos == data && hole >= size))
         return false;
 
-    validus_init(state);
-    validus_append(state, mem, len);
-    validus_finalize(state);
+    uint64_t off = pos;
+
+    while (off < size) {
+        /* the hole [off, data). */
+        while (off < data) {
+            size_t len = (size_t)((data - off) < sizeof(zeros) ? (data - off) : sizeof(zeros));
+            VALIDUS_STAT_TIMED(VALIDUS_STAT_COMPUTE_NS, validus_stream_write(stream, zeros, len));
+            off += len;
+        }
+
+        /* the data [off, hole). direct I/O needs whole blocks, even at the end
+         * of the file; the surplus is never read there. */
+        uint64_t start = off;
+        while (off < hole) {
+            size_t want = (size_t)((hole - off) < blocksize ? (hole - off) : blocksize);
+            size_t len  = want;
+            if (flags & VALIDUS_IO_DIRECT)
+                len = (len + VALIDUS_IO_ALIGN - 1) & ~((size_t)VALIDUS_IO_ALIGN - 1);
+
+            size_t got = 0;
+            if (!_validus_file_pread(fd, buf, len, off, &got)) {
+                *failed = true;
+                goto _done;
+            }
+            if (0 == got)
+                goto _done; /* the file shrank. */
+
+            got = got < want ? got : want;
+            VALIDUS_STAT_TIMED(VALIDUS_STAT_COMPUTE_NS, validus_stream_write(stream, buf, got));
+            off += got;
+        }
+
+        if ((flags & VALIDUS_IO_NOCACHE) && off > start)
+            _validus_file_drop(fd, start, off - start);
+
+        if (off >= size)
+            break;
+
+        if (!_validus_file_extent(fd, off, size, &data, &hole)) {
+            *failed = true;
+            goto _done;
+        }
+    }
 
+_done:
+    (void)_validus_file_seek(fd, off);
     return true;
 }
 
-bool validus_hash_file(validus_state* state, const char* file) {
-  if (!state || (!file || !*file))
-      return false;
+/** Computes the check of the last VALIDUS_RESUME_TAIL (or more) octets of a
+ * regular file of `size` octets. The read starts on a multiple of
+ * VALIDUS_IO_ALIGN, so that it is allowed with VALIDUS_IO_DIRECT. */
+static bool _validus_hash_tail(validus_fd fd, uint64_t size, uint32_t flags, uint64_t* check)
+{
+    uint64_t off = 0;
+    if (size > VALIDUS_RESUME_TAIL)
+        off = (size - VALIDUS_RESUME_TAIL) & ~((uint64_t)VALIDUS_IO_ALIGN - 1);
+
+    size_t len  = (size_t)(size - off);
+    size_t want = (len + VALIDUS_IO_ALIGN - 1) & ~((size_t)VALIDUS_IO_ALIGN - 1);
+    size_t got  = 0;
 
-    FILE *f = fopen(file, "rb");
-    if (!f) {
-        fprintf(stderr, "failed to open file '%s': %d\n", file, errno);
+    validus_octet* buf = _validus_io_buffer(want, flags);
+    if (!buf || !_validus_file_pread(fd, buf, want, off, &got) || got < len)
         return false;
-    }
 
-    validus_octet *buf = calloc(sizeof(validus_octet), VALIDUS_FILE_BLOCKSIZE);
+    validus_state state;
+    validus_init(&state);
+    validus_append(&state, buf, len);
+    validus_finalize(&state);
+
+    *check = (uint64_t)state.f0 << 32 | state.f1;
+    return true;
+}
+
+/** Hashes a regular file into `stream` from `off` (where `stream` left off) to
+ * its end. As with ::_validus_hash_tail, reads start on a multiple of
+ * VALIDUS_IO_ALIGN, and what precedes `off` is skipped. */
+static bool _validus_hash_from(validus_stream* stream, validus_fd fd, const char* name,
+    uint64_t off, const validus_io_options* opts)
+{
+    const uint64_t start   = VALIDUS_STAT_NOW();
+    const uint64_t compute = VALIDUS_STAT_VALUE(VALIDUS_STAT_COMPUTE_NS);
+
+    uint32_t flags   = opts ? opts->flags : 0U;
+    size_t blocksize = (flags & VALIDUS_IO_DIRECT) ? VALIDUS_DIRECT_BLOCKSIZE : VALIDUS_FILE_BLOCKSIZE;
+    if (opts && opts->read_size > 0)
+        blocksize = opts->read_size;
+    blocksize = (blocksize + VALIDUS_IO_ALIGN - 1) & ~((size_t)VALIDUS_IO_ALIGN - 1);
 
-    if (!buf) {
-        fprintf(stderr, "failed to allocate %zu octets of heap memory: %d\n",
-            sizeof(validus_octet) * VALIDUS_FILE_BLOCKSIZE, errno);
-        fclose(f);
-        f = NULL;
+    validus_octet* buf = _validus_io_buffer(blocksize, flags);
+    if (!buf)
         return false;
+
+    _validus_file_advise(fd, flags);
+
+    uint64_t pos = off & ~((uint64_t)VALIDUS_IO_ALIGN - 1);
+    size_t skip  = (size_t)(off - pos);
+    bool failed  = false;
+
+    for (;;) {
+        size_t got = 0;
+        if (!_validus_file_pread(fd, buf, blocksize, pos, &got)) {
+            failed = true;
+            break;
+        }
+        if (got <= skip)
+            break;
+        VALIDUS_STAT_TIMED(VALIDUS_STAT_COMPUTE_NS,
+            validus_stream_write(stream, buf + skip, got - skip));
+
+        pos += got;
+        skip = 0;
+        if (got < blocksize)
+            break;
     }
 
-    bool retval = false;
-    validus_init(state);
+    if (flags & VALIDUS_IO_NOCACHE)
+        _validus_file_drop(fd, off & ~((uint64_t)VALIDUS_IO_ALIGN - 1), 0);
 
-    while (!feof(f) && !ferror(f)) {
-        size_t result = fread((void*)buf, sizeof(validus_octet),
-            VALIDUS_FILE_BLOCKSIZE, f);
+    VALIDUS_STAT_ADD(VALIDUS_STAT_IO_NS, (VALIDUS_STAT_NOW() - start) -
+        (VALIDUS_STAT_VALUE(VALIDUS_STAT_COMPUTE_NS) - compute));
 
-        if (0 != result)
-            validus_append(state, buf, result);
+    if (failed) {
+        fprintf(stderr, "failed to read from file '%s'\n", name);
+        return false;
     }
 
-    if (0 != ferror(f)) {
-        fprintf(stderr, "failed to read from file '%s': %d\n", file, errno);
+    return true;
+}
+
+bool validus_hash_file_ex(validus_state* state, const char* file, uint32_t flags)
+{
+    validus_io_options opts = {0};
+    opts.flags              = flags;
+
+    return validus_hash_file_opts(state, file, &opts);
+}
+
+bool validus_hash_file_opts(validus_state* state, const char* file,
+    const validus_io_options* opts)
+{
+    if (!state || (!file || !*file))
+        return false;
+
+    validus_fd fd = _validus_file_open(file, opts ? opts->flags : 0U);
+    if (VALIDUS_INVALID_FD == fd)
+        return false;
+
+    bool ok = _validus_hash_file_fd(state, fd, file, opts);
+    _validus_file_close(fd);
+
+    return ok;
+}
+
+bool _validus_hash_file_fd(validus_state* state, validus_fd fd, const char* name,
+    const validus_io_options* opts)
+{
+    validus_file_id id;
+    bool cached = opts && opts->cache && _validus_file_id(fd, &id);
+    bool lookup = cached && !(opts->flags & VALIDUS_IO_REHASH);
+    bool append = cached && (opts->flags & VALIDUS_IO_APPEND);
+
+    if (lookup && _validus_cache_get(opts->cache, &id, state))
+        return true;
+
+    validus_stream stream;
+    validus_stream_init(&stream);
+
+    /* a file that has grown, with its old end unchanged, is taken to have been
+     * appended to: hashing resumes where its entry left off. */
+    validus_cache_mid mid;
+    uint64_t tail = 0;
+    bool ok;
+
+    if (lookup && append && _validus_cache_get_mid(opts->cache, &id, &mid) &&
+        _validus_hash_tail(fd, mid.size, opts->flags, &tail) && tail == mid.tail) {
+        stream.state = mid.state;
+        stream.total = mid.offset;
+        ok = _validus_hash_from(&stream, fd, name, mid.offset, opts);
     } else {
-        validus_finalize(state);
-        retval = true;
+        ok = _validus_hash_stream(&stream, fd, name, opts);
+    }
+
+    if (!ok)
+        return false;
+
+    /* the state before finalization, to resume from once the file grows. */
+    bool resumable = false;
+    if (append) {
+        memset(&mid, 0, sizeof(mid));
+        mid.size   = id.size;
+        mid.offset = stream.total - stream.used;
+        mid.state  = stream.state;
+        resumable  = mid.offset > 0 && _validus_hash_tail(fd, id.size, opts->flags, &mid.tail);
+    }
+
+    validus_stream_finalize(&stream);
+    *state = stream.state;
+
+    /* a file that changed while it was being read is not recorded. */
+    validus_file_id after;
+    if (cached && _validus_file_id(fd, &after) && 0 == memcmp(&id, &after, sizeof(id)))
+        _validus_cache_put(opts->cache, &id, state, resumable ? &mid : NULL);
+
+    return true;
+}
+
+bool _validus_hash_fd(validus_state* state, validus_fd fd, const char* name,
+    const validus_io_options* opts)
+{
+    validus_stream stream;
+    validus_stream_init(&stream);
+
+    if (!_validus_hash_stream(&stream, fd, name, opts))
+        return false;
+
+    validus_stream_finalize(&stream);
+    *state = stream.state;
+
+    return true;
+}
+
+bool _validus_hash_stream(validus_stream* stream, validus_fd fd, const char* name,
+    const validus_io_options* opts)
+{
+    /* whatever is not spent hashing is spent reading and mapping. */
+    const uint64_t start   = VALIDUS_STAT_NOW();
+    const uint64_t compute = VALIDUS_STAT_VALUE(VALIDUS_STAT_COMPUTE_NS);
+
+    uint32_t flags   = opts ? opts->flags : 0U;
+    size_t read_size = opts ? opts->read_size : 0;
+
+    if (flags & (VALIDUS_IO_POPULATE | VALIDUS_IO_HUGEPAGES))
+        flags |= VALIDUS_IO_MMAP;
+
+    /* mappings are read through the page cache. */
+    if (flags & VALIDUS_IO_DIRECT)
+        flags &= ~(VALIDUS_IO_MMAP | VALIDUS_IO_POPULATE | VALIDUS_IO_HUGEPAGES);
+
+    uint64_t size = 0;
+    bool regular  = false;
+    bool failed   = false;
+    bool mapped   = false; /* whether input was consumed by mapping or pipeline. */
+
+    if (!_validus_file_stat(fd, &size, &regular))
+        regular = false;
+
+    /* the input may have been partly consumed already (stdin, say). */
+    uint64_t pos = 0;
+    if (regular && !_validus_file_tell(fd, &pos))
+        regular = false;
+
+    if (regular)
+        _validus_file_advise(fd, flags);
+
+    /* mappings start on a page boundary, so only from the start of the file. */
+    if ((flags & VALIDUS_IO_MMAP) && regular && 0 == pos && size > 0)
+        mapped = _validus_hash_mapped(stream, fd, size, flags, &failed);
+
+    /* pipes and FIFOs: ask for a bigger pipe, and read in bigger chunks. */
+    size_t blocksize = VALIDUS_FILE_BLOCKSIZE;
+    if (!mapped && !regular) {
+        _validus_pipe_grow(fd);
+        blocksize = VALIDUS_PIPE_BLOCKSIZE;
     }
 
-    free(buf);
-    buf = NULL;
+    if (flags & VALIDUS_IO_DIRECT)
+        blocksize = VALIDUS_DIRECT_BLOCKSIZE;
+    if (read_size > 0)
+        blocksize = read_size;
+    if (flags & VALIDUS_IO_DIRECT)
+        blocksize = (blocksize + VALIDUS_IO_ALIGN - 1) & ~((size_t)VALIDUS_IO_ALIGN - 1);
 
-    fclose(f);
-    f = NULL;
+    validus_octet* buf = NULL;
+    if (!mapped && !(buf = _validus_io_buffer(blocksize, flags)))
+        return false;
+
+    /* holes are not read at all, so the sparse path beats the pipeline. */
+    if (!mapped && regular && pos < size)
+        mapped = _validus_hash_sparse(stream, fd, pos, size, buf, blocksize, flags, &failed);
+
+    if (!mapped && (flags & VALIDUS_IO_ASYNC))
+        mapped = _validus_hash_async(stream, fd, &failed);
+
+    if (!mapped) {
+        uint64_t off = 0, dropped = 0;
+
+        for (;;) {
+            size_t got = 0;
+            if (!_validus_file_read(fd, buf, blocksize, &got)) {
+                failed = true;
+                break;
+            }
+            if (0 == got)
+                break;
+            VALIDUS_STAT_TIMED(VALIDUS_STAT_COMPUTE_NS, validus_stream_write(stream, buf, got));
+
+            off += got;
+            if (regular && (flags & VALIDUS_IO_NOCACHE) && off - dropped >= VALIDUS_NOCACHE_WINDOW) {
+                _validus_file_drop(fd, dropped, off - dropped);
+                dropped = off;
+            }
+        }
+    }
+
+    /* whatever was not dropped along the way (or was mapped). */
+    if (regular && (flags & VALIDUS_IO_NOCACHE))
+        _validus_file_drop(fd, 0, 0);
+
+    VALIDUS_STAT_ADD(VALIDUS_STAT_IO_NS, (VALIDUS_STAT_NOW() - start) -
+        (VALIDUS_STAT_VALUE(VALIDUS_STAT_COMPUTE_NS) - compute));
+
+    if (failed) {
+        fprintf(stderr, "failed to read from file '%s'\n", name);
+        return false;
+    }
 
-    return retval;
+    return true;
 }
 
 bool validus_state_to_string(const validus_state* state, char* out, size_t len)
@@ -110,19 +434,53 @@ bool validus_state_to_string(const validus_state* state, char* out, size_t len)
     return -1 != prn;
 }
 
+bool validus_state_from_string(validus_state* state, const char* str)
+{
+    if (!state || !str)
+        return false;
+
+    validus_word words[6] = {0};
+
+    for (size_t n = 0; n < 6 * 8; n++) {
+        char c = str[n];
+        validus_word digit;
+
+        if (c >= '0' && c <= '9')
+            digit = (validus_word)(c - '0');
+        else if (c >= 'a' && c <= 'f')
+            digit = (validus_word)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')
+            digit = (validus_word)(c - 'A' + 10);
+        else
+            return false;
+
+        words[n / 8] = (words[n / 8] << 4) | digit;
+    }
+
+    memset(state, 0, sizeof(validus_state));
+    state->f0 = words[0];
+    state->f1 = words[1];
+    state->f2 = words[2];
+    state->f3 = words[3];
+    state->f4 = words[4];
+    state->f5 = words[5];
+
+    return true;
+}
+
 ////////////////////////// internal functions //////////////////////////////////
 
 void validus_timer_start(validus_timer* timer)
 {
 #if !defined(__WIN__)
-    int ret = clock_gettime(CLOCK_REALTIME, &timer->ts);
+    int ret = clock_gettime(CLOCK_MONOTONIC, &timer->ts);
     if (0 != ret) {
         fprintf(stderr, "clock_gettime() failed: %d\n", errno);
         timer->ts.tv_sec = 0;
         timer->ts.tv_nsec = 0;
     }
 #else /* __WIN__ */
-    GetSystemTimePreciseAsFileTime(&timer->ft);
+    (void)QueryPerformanceCounter(&timer->counter);
 #endif
 }
 
@@ -131,26 +489,21 @@ double validus_timer_elapsed(const validus_timer* timer)
     validus_timer now;
 
 #if !defined(__WIN__)
-    int ret = clock_gettime(CLOCK_REALTIME, &now.ts);
+    int ret = clock_gettime(CLOCK_MONOTONIC, &now.ts);
     if (0 != ret) {
         fprintf(stderr, "clock_gettime() failed: %d\n", errno);
         return 0.0;
     }
 
-    return ((((double)now.ts.tv_sec * 1e3) + ((double)now.ts.tv_nsec / 1e6)) -
-        (((double)timer->ts.tv_sec * 1e3) + ((double)timer->ts.tv_nsec / 1e6)));
+    return ((double)(now.ts.tv_sec - timer->ts.tv_sec) * 1e3) +
+        ((double)(now.ts.tv_nsec - timer->ts.tv_nsec) / 1e6);
 #else /* __WIN__ */
-    GetSystemTimePreciseAsFileTime(&now.ft);
-
-    ULARGE_INTEGER ulnow;
-    ulnow.LowPart = now.ft.dwLowDateTime;
-    ulnow.HighPart = now.ft.dwHighDateTime;
-
-    ULARGE_INTEGER ultimer;
-    ultimer.LowPart = timer->ft.dwLowDateTime;
-    ultimer.HighPart = timer->ft.dwHighDateTime;
+    LARGE_INTEGER freq;
+    (void)QueryPerformanceFrequency(&freq);
+    (void)QueryPerformanceCounter(&now.counter);
 
-    return (float)((ulnow.QuadPart - ultimer.QuadPart) / 1e4);
+    return (double)(now.counter.QuadPart - timer->counter.QuadPart) * 1e3 /
+        (double)freq.QuadPart;
 #endif
 }
 
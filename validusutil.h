@@ -61,6 +61,113 @@
 /** The size, in octets used to read blocks of data from a file. */
 # define VALIDUS_FILE_BLOCKSIZE 8192UL
 
+/** The size, in octets, of the reads from pipes, FIFOs and other streams. */
+# define VALIDUS_PIPE_BLOCKSIZE (1024UL * 1024UL)
+
+/** The capacity, in octets, requested for pipes that are read (F_SETPIPE_SZ). */
+# define VALIDUS_PIPE_SIZE (1024 * 1024)
+
+/** The alignment, in octets, of read buffers. */
+# define VALIDUS_IO_ALIGN 4096
+
+/** The size, in octets, of the windows in which files are memory-mapped. */
+# define VALIDUS_MMAP_WINDOW (1024UL * 1024UL * 1024UL)
+
+/** File I/O flag: read the file through a memory mapping, where possible. */
+# define VALIDUS_IO_MMAP      0x01U
+
+/** File I/O flag: prefault the mapping (MAP_POPULATE). Implies VALIDUS_IO_MMAP. */
+# define VALIDUS_IO_POPULATE  0x02U
+
+/** File I/O flag: request transparent huge pages for the mapping. Implies
+ * VALIDUS_IO_MMAP. */
+# define VALIDUS_IO_HUGEPAGES 0x04U
+
+/** File I/O flag: overlap reading and hashing, with several reads in flight
+ * (io_uring, or a reader thread). */
+# define VALIDUS_IO_ASYNC     0x08U
+
+/** File I/O flag: bypass the page cache (O_DIRECT, F_NOCACHE or
+ * FILE_FLAG_NO_BUFFERING), reading into page-aligned buffers. Takes precedence
+ * over VALIDUS_IO_MMAP. */
+# define VALIDUS_IO_DIRECT    0x10U
+
+/** File I/O flag: advise the kernel that the file is read sequentially
+ * (POSIX_FADV_SEQUENTIAL), so that it reads ahead more aggressively. */
+# define VALIDUS_IO_SEQUENTIAL 0x20U
+
+/** File I/O flag: drop the file's pages from the page cache as they are
+ * consumed (POSIX_FADV_DONTNEED), so that hashing does not evict other data. */
+# define VALIDUS_IO_NOCACHE   0x40U
+
+/** File I/O flag: back the read buffer with huge pages, where available. */
+# define VALIDUS_IO_HUGEBUF   0x80U
+
+/** File I/O flag: with a cache (::validus_io_options::cache), hash every file
+ * regardless of its entry, and refresh the entry. */
+# define VALIDUS_IO_REHASH    0x100U
+
+/** File I/O flag: with a cache (::validus_io_options::cache), treat files that
+ * have grown as append-only, and hash only the octets added since their entry
+ * was recorded (see ::validus_hash_file_opts). */
+# define VALIDUS_IO_APPEND    0x200U
+
+/** The size, in octets, of reads that bypass the page cache (VALIDUS_IO_DIRECT),
+ * unless ::validus_io_options::read_size says otherwise. */
+# define VALIDUS_DIRECT_BLOCKSIZE (1024UL * 1024UL)
+
+/** The interval, in octets, at which consumed pages are dropped from the page
+ * cache with VALIDUS_IO_NOCACHE. */
+# define VALIDUS_NOCACHE_WINDOW (8UL * 1024UL * 1024UL)
+
+/** The number of entries in a new fingerprint cache, unless specified. Each
+ * entry is 128 octets; the file is sparse until entries are written. */
+# define VALIDUS_CACHE_SLOTS (1UL << 24)
+
+/** The number of slots probed for an entry in the fingerprint cache. */
+# define VALIDUS_CACHE_PROBES 16
+
+/** Files changed more recently than this (in nanoseconds) are not cached: on
+ * filesystems with coarse timestamps, a later write could leave them as-is. */
+# define VALIDUS_CACHE_SETTLE_NS 2000000000LL
+
+/** The minimum number of octets at the end of a file that are compared before
+ * its hash is resumed (VALIDUS_IO_APPEND). */
+# define VALIDUS_RESUME_TAIL 4096
+
+/** The size, in octets, of each read issued by the asynchronous reader. */
+# define VALIDUS_ASYNC_BLOCKSIZE (1024UL * 1024UL)
+
+/** The number of reads the asynchronous reader keeps in flight. */
+# define VALIDUS_ASYNC_DEPTH 4
+
+/** The size, in octets, of a leaf in tree mode. */
+# define VALIDUS_TREE_LEAFSIZE (1024UL * 1024UL)
+
+/** The largest read, in octets, issued while hashing a file's ranges. */
+# define VALIDUS_RANGES_READSIZE (1024UL * 1024UL)
+
+/** The version of the signature file format (see ::validus_signature_write). */
+# define VALIDUS_SIGNATURE_VERSION 1
+
+/** The size, in octets, of a signature file's header, and of each entry. */
+# define VALIDUS_SIGNATURE_HEADER 32
+# define VALIDUS_SIGNATURE_ENTRY  24
+
+/** Directory walk flag: follow symbolic links to files and directories. */
+# define VALIDUS_DIR_FOLLOW 0x01U
+
+/** Directory walk flag: do not descend into directories on other filesystems. */
+# define VALIDUS_DIR_XDEV   0x02U
+
+/** The maximum number of files in flight (being hashed, or awaiting their turn
+ * to be reported) during a directory walk. */
+# define VALIDUS_DIR_WINDOW 1024
+
+/** The number of concurrent readers allowed per rotational (spinning) device
+ * when verifying a manifest. */
+# define VALIDUS_VERIFY_HDD_READERS 1
+
 /** The maximum size, in octets of a string to hash. */
 # define VALIDUS_MAX_STRING 2048UL
 
@@ -68,6 +175,89 @@
 # define VALIDUS_FP_FMT_SPEC \
     "%08" PRIx32 "%08" PRIx32 "%08" PRIx32 "%08" PRIx32 "%08" PRIx32 "%08" PRIx32
 
+/////////////////////////////// typedefs ///////////////////////////////////////
+
+/**
+ * A persistent fingerprint cache: a memory-mapped, open-addressing table of
+ * fingerprints keyed by device, inode, size, and modification and change
+ * times. Shared by any number of threads and processes.
+ */
+typedef struct validus_cache validus_cache;
+
+/** Controls how ::validus_hash_file_opts reads a file. Zero-initialize for the
+ * defaults. */
+typedef struct {
+    uint32_t flags;       /**< Bitwise OR of VALIDUS_IO_* flags, or zero. */
+    size_t read_size;     /**< Octets per read; zero for VALIDUS_FILE_BLOCKSIZE (files),
+                               VALIDUS_PIPE_BLOCKSIZE (pipes) or VALIDUS_DIRECT_BLOCKSIZE
+                               (with VALIDUS_IO_DIRECT). Rounded up to VALIDUS_IO_ALIGN
+                               with VALIDUS_IO_DIRECT. */
+    validus_cache* cache; /**< Consulted and updated, if not NULL. */
+} validus_io_options;
+
+/**
+ * Receives the result for one file of a directory walk: `state` holds the
+ * file's fingerprint, or is NULL if the file could not be hashed.
+ */
+typedef void (*validus_dir_fn)(void* ctx, const char* path, const validus_state* state);
+
+/**
+ * A keyed (MAC) context, prepared once per key by ::validus_keyed_init and
+ * reused for any number of messages.
+ */
+typedef struct {
+    validus_stream inner; /**< Midstate after the inner (ipad) key block. */
+    validus_stream outer; /**< Midstate after the outer (opad) key block. */
+} validus_keyed;
+
+/** Totals produced by ::validus_verify_manifest. */
+typedef struct {
+    size_t entries;    /**< Well-formed entries in the manifest. */
+    size_t passed;     /**< Entries whose fingerprint matched. */
+    size_t mismatched; /**< Entries whose fingerprint did not match. */
+    size_t unreadable; /**< Entries whose file could not be read. */
+    size_t malformed;  /**< Lines that could not be parsed. */
+} validus_verify_totals;
+
+/**
+ * Hot-path counters, summed over every thread (including those that have
+ * exited) since the process started. Compare two snapshots to measure an
+ * interval.
+ */
+typedef struct {
+    uint64_t bytes;        /**< Octets appended or written to streams. */
+    uint64_t full_blocks;  /**< Whole blocks compressed without padding. */
+    uint64_t padded_tails; /**< Partial blocks zero-padded before compression. */
+    uint64_t unaligned;    /**< Blocks copied to the stack because they were not
+                                word-aligned. */
+    uint64_t finalizes;    /**< Calls to ::validus_finalize. */
+    uint64_t io_ns;        /**< Nanoseconds spent reading in ::validus_hash_file_ex. */
+    uint64_t compute_ns;   /**< Nanoseconds spent hashing in ::validus_hash_file_ex. */
+} validus_stats;
+
+/**
+ * Receives an entry that failed verification: `actual` holds the file's
+ * fingerprint, or is NULL if the file could not be read.
+ */
+typedef void (*validus_verify_fn)(void* ctx, const char* path,
+    const validus_state* expected, const validus_state* actual);
+
+/**
+ * The fingerprints of consecutive, fixed-size ranges of a file, as produced by
+ * ::validus_hash_ranges: range `n` covers octets [n * range_size, (n + 1) *
+ * range_size), and the last may be shorter.
+ */
+typedef struct {
+    uint64_t size;         /**< Size of the file, in octets. */
+    uint64_t range_size;   /**< Size of each range, in octets. */
+    size_t count;          /**< Number of ranges. */
+    validus_state* ranges; /**< One fingerprint per range. */
+} validus_signature;
+
+/** Receives a run of changed ranges from ::validus_signature_diff: `len`
+ * octets starting at `offset`. */
+typedef void (*validus_range_fn)(void* ctx, uint64_t offset, uint64_t len);
+
 //////////////////////////// function exports //////////////////////////////////
 
 # ifdef __cplusplus
@@ -83,7 +273,7 @@ extern "C" {
  *                 null terminator, or VALIDUS_MAX_STRING; whichever comes first.
  * @returns bool   `true` if input parameters are valid, `false` otherwise.
  */
-bool validus_hash_string(validus_state* state, const char* string);
+VALIDUS_API bool validus_hash_string(validus_state* state, const char* string);
 
 /**
  * @brief Hashes a block of memory.
@@ -94,7 +284,7 @@ bool validus_hash_string(validus_state* state, const char* string);
  * @param   len   Length of `mem` in octets.
  * @returns bool `true` if input parameters are valid, `false` otherwise.
  */
-bool validus_hash_mem(validus_state* state, const void* mem, size_t len);
+VALIDUS_API bool validus_hash_mem(validus_state* state, const void* mem, size_t len);
 
 /**
  * @brief Hashes a file.
@@ -104,7 +294,11 @@ bool validus_hash_mem(validus_state* state, const void* mem, size_t len);
  * that this program resides in.
  *
  * @note The preprocessor macro VALIDUS_FILE_BLOCKSIZE may be modified at compile
- * time to suit your needs if the default value (8 KiB) is insufficient.
+ * time to suit your needs if the default value (8 KiB) is insufficient. Pipes
+ * and FIFOs are enlarged where possible, and read VALIDUS_PIPE_BLOCKSIZE octets
+ * at a time. The file is hashed through a ::validus_stream, so the fingerprint
+ * does not depend upon either: it is identical to that of ::validus_hash_mem
+ * over the file's contents.
  *
  * @param   state Pointer to a validus_state object which will contain the
  *                results of the operation upon success.
@@ -114,6 +308,360 @@ bool validus_hash_mem(validus_state* state, const void* mem, size_t len);
  */
 bool validus_hash_file(validus_state *state, const char *file);
 
+/**
+ * @brief Hashes a file, with control over how it is read.
+ *
+ * With VALIDUS_IO_MMAP, regular files are mapped (in windows of
+ * VALIDUS_MMAP_WINDOW octets) and hashed directly from the page cache, with
+ * sequential access advice. Pipes, special files, empty files, and files that
+ * cannot be mapped are read with read(2) instead.
+ *
+ * With VALIDUS_IO_ASYNC, files that are not mapped are read by a pipeline which
+ * keeps VALIDUS_ASYNC_DEPTH reads of VALIDUS_ASYNC_BLOCKSIZE octets in flight
+ * while the hasher consumes completed buffers, so that I/O and hashing overlap.
+ * io_uring is used where available; otherwise, a reader thread.
+ *
+ * Regular files that are not mapped, and that have holes, are read extent by
+ * extent (found with SEEK_DATA/SEEK_HOLE, where supported); the holes are
+ * hashed from a zero page, without being read.
+ *
+ * The fingerprint is the same regardless of the flags.
+ *
+ * @param   state Pointer to a validus_state object which will contain the
+ *                results of the operation upon success.
+ * @param   file  Absolute or relative pathname to the file to hash.
+ * @param   flags Bitwise OR of VALIDUS_IO_* flags, or zero.
+ * @returns bool  `true` if the file is opened and read successfully, `false`
+ *                otherwise.
+ */
+bool validus_hash_file_ex(validus_state* state, const char* file, uint32_t flags);
+
+/**
+ * @brief Hashes a file, with full control over how it is read.
+ *
+ * Behaves as ::validus_hash_file_ex with `opts->flags`, and additionally:
+ *
+ * - `opts->read_size` sets the size of each read.
+ * - With VALIDUS_IO_DIRECT, the page cache is bypassed; the file is read into
+ *   page-aligned buffers, in multiples of VALIDUS_IO_ALIGN. If the filesystem
+ *   does not support it, the file is read normally.
+ * - With VALIDUS_IO_SEQUENTIAL and VALIDUS_IO_NOCACHE, the corresponding
+ *   posix_fadvise hints are given (on platforms that have them).
+ * - With VALIDUS_IO_HUGEBUF, the read buffer is backed by huge pages (explicit
+ *   ones if any are reserved, transparent ones otherwise).
+ * - With VALIDUS_IO_APPEND and `opts->cache`, the state before finalization
+ *   is recorded along with the fingerprint. When the file is next found to
+ *   have grown, and its last VALIDUS_RESUME_TAIL (or more) octets as of that
+ *   entry are unchanged, hashing resumes from that state, and only the octets
+ *   after it are read. This trusts the file not to have been modified other
+ *   than by appending: a change before the octets compared goes unnoticed.
+ *
+ * The read buffer belongs to the calling thread, and is kept for its next
+ * call (it is only reallocated if it is too small), so hashing many files
+ * costs no allocations per file. It is freed when the thread exits, or by
+ * ::validus_io_release.
+ *
+ * The fingerprint is the same regardless of the options.
+ *
+ * @param   state Pointer to a validus_state object which will contain the
+ *                results of the operation upon success.
+ * @param   file  Absolute or relative pathname to the file to hash.
+ * @param   opts  The options; NULL for the defaults.
+ * @returns bool  `true` if the file is opened and read successfully, `false`
+ *                otherwise.
+ */
+bool validus_hash_file_opts(validus_state* state, const char* file,
+    const validus_io_options* opts);
+
+/**
+ * @brief Opens (creating, if necessary) a persistent fingerprint cache.
+ *
+ * With a cache in ::validus_io_options::cache, ::validus_hash_file_opts
+ * returns the cached fingerprint of a regular file whose device, inode, size,
+ * and modification and change times (to the nanosecond) are unchanged, without
+ * reading it. Otherwise, it hashes the file and records the result, unless the
+ * file changed while it was being read, or within the last
+ * VALIDUS_CACHE_SETTLE_NS (with VALIDUS_IO_APPEND, such a file's state before
+ * finalization is still recorded, to be resumed once it has grown).
+ *
+ * The table does not grow: an entry is placed in one of VALIDUS_CACHE_PROBES
+ * slots, and when they are all taken, the first is replaced.
+ *
+ * Entries are updated without locks, and carry a checksum: an entry that is
+ * torn (by a concurrent writer, or a crash) reads as a miss, so it is hashed
+ * again. A new (or damaged) cache file is initialized under flock(2).
+ *
+ * @note Not supported on Windows.
+ *
+ * @param   path  Absolute or relative pathname of the cache file.
+ * @param   slots The number of entries (rounded up to a power of two, at most
+ *                2^32); 0 for VALIDUS_CACHE_SLOTS. An existing file keeps its
+ *                own size, unless a larger `slots` is given: it then grows,
+ *                keeping its entries. The table never grows by itself; once
+ *                its probe chains are full, new files are not cached.
+ * @returns validus_cache* The cache, or NULL (having reported the error on
+ *                stderr) if it could not be opened.
+ */
+validus_cache* validus_cache_open(const char* path, size_t slots);
+
+/** @brief Closes a cache opened by ::validus_cache_open. */
+void validus_cache_close(validus_cache* cache);
+
+/**
+ * @brief Frees the calling thread's read buffer, if it has one.
+ *
+ * Threads that exit free theirs automatically; this is for long-lived threads
+ * that are done hashing files.
+ */
+void validus_io_release(void);
+
+/**
+ * @brief Hashes a block of memory in tree mode.
+ *
+ * Tree mode splits the input into leaves of VALIDUS_TREE_LEAFSIZE octets,
+ * fingerprints the leaves in parallel, and then fingerprints the concatenation
+ * of the leaf fingerprints, the input length and the leaf size to produce the
+ * root fingerprint. The root starts from a distinct initial state, so it never
+ * equals the plain fingerprint of those octets.
+ *
+ * @attention Tree mode is a distinct hash: its fingerprints do not match those
+ * produced by ::validus_hash_mem or ::validus_hash_file for the same input.
+ *
+ * @param   state   Pointer to a validus_state object which will contain the
+ *                  root fingerprint upon success.
+ * @param   mem     Pointer to the area of memory to hash.
+ * @param   len     Length of `mem` in octets.
+ * @param   threads Number of worker threads; 0 to use one per CPU.
+ * @returns bool    `true` if input parameters are valid and hashing succeeds,
+ *                  `false` otherwise.
+ */
+bool validus_tree_hash_mem(validus_state* state, const void* mem, size_t len,
+    size_t threads);
+
+/**
+ * @brief Hashes a file in tree mode.
+ *
+ * The file's leaves are read and fingerprinted in parallel. See
+ * ::validus_tree_hash_mem for a description of tree mode. The file must be a
+ * regular file: pipes, FIFOs and the like are rejected.
+ *
+ * @param   state   Pointer to a validus_state object which will contain the
+ *                  root fingerprint upon success.
+ * @param   file    Absolute or relative pathname to the file to hash.
+ * @param   threads Number of worker threads; 0 to use one per CPU.
+ * @returns bool    `true` if the file is opened and read successfully, `false`
+ *                  otherwise.
+ */
+bool validus_tree_hash_file(validus_state* state, const char* file, size_t threads);
+
+/**
+ * @brief Returns the number of ranges of `range_size` octets in `size` octets.
+ *
+ * @returns size_t The count; 0 if `size` or `range_size` is 0, or if there are
+ *                 too many ranges to hold in memory.
+ */
+size_t validus_range_count(uint64_t size, uint64_t range_size);
+
+/**
+ * @brief Fingerprints each range of `range_size` octets of a file.
+ *
+ * The ranges are read with pread(2) and hashed in parallel. Each fingerprint
+ * is that of the range's octets alone, as ::validus_hash_mem would produce
+ * for them, so that ranges can be compared between files (or versions of a
+ * file) without reading either again: see ::validus_signature_diff.
+ *
+ * @param   sig        Receives the signature upon success; free it with
+ *                     ::validus_signature_free.
+ * @param   file       Absolute or relative pathname to the file to hash.
+ * @param   range_size Size of each range, in octets.
+ * @param   threads    Number of worker threads; 0 to use one per CPU.
+ * @returns bool       `true` if the file is opened and read successfully,
+ *                     `false` otherwise.
+ */
+bool validus_hash_ranges(validus_signature* sig, const char* file, uint64_t range_size,
+    size_t threads);
+
+/** @brief Frees the ranges of a signature produced by ::validus_hash_ranges or
+ * ::validus_signature_read. */
+void validus_signature_free(validus_signature* sig);
+
+/**
+ * @brief Writes a signature file.
+ *
+ * The format is compact, and fixed-width so that range `n` is at a known
+ * offset: a header of VALIDUS_SIGNATURE_HEADER octets ("VLDR", the version
+ * octet, three zero octets, then the file size, range size and range count as
+ * little-endian 64-bit values), followed by one VALIDUS_SIGNATURE_ENTRY-octet
+ * entry per range (f0..f5 as little-endian 32-bit words).
+ *
+ * @returns bool `true` if it was written in full, `false` otherwise.
+ */
+bool validus_signature_write(const validus_signature* sig, FILE* out);
+
+/**
+ * @brief Reads a signature file written by ::validus_signature_write.
+ *
+ * @returns bool `true` upon success (free `sig` with ::validus_signature_free),
+ *               `false` if it could not be read, or is not a valid signature
+ *               file.
+ */
+bool validus_signature_read(validus_signature* sig, FILE* in);
+
+/**
+ * @brief Finds the ranges of a file that changed between two signatures.
+ *
+ * Calls `fn` for each run of consecutive ranges of `new_sig` that are not in
+ * `old_sig` with the same length and fingerprint, in order of offset. Ranges
+ * past the end of `new_sig` are not reported; compare the two sizes to detect
+ * a file that shrank.
+ *
+ * @returns bool `true` if the signatures were compared, `false` if their range
+ *               sizes differ (or an argument is NULL).
+ */
+bool validus_signature_diff(const validus_signature* old_sig, const validus_signature* new_sig,
+    validus_range_fn fn, void* ctx);
+
+/**
+ * @brief Prepares a keyed (MAC) context for `key`.
+ *
+ * Keyed fingerprints use the HMAC construction over Validus: the key (or, if
+ * it is longer than a block, its fingerprint) is zero-padded to a block, and
+ * the inner and outer key blocks are compressed here, once, so that each
+ * message costs only its own blocks and two finalizations.
+ *
+ * @param   keyed Pointer to the validus_keyed object to prepare.
+ * @param   key   The key. May be NULL if `len` is zero.
+ * @param   len   Length of `key` in octets.
+ * @returns bool  `true` if input parameters are valid, `false` otherwise.
+ */
+bool validus_keyed_init(validus_keyed* keyed, const void* key, size_t len);
+
+/**
+ * @brief Computes the keyed fingerprint of a message.
+ *
+ * @param   keyed Pointer to a validus_keyed object prepared by ::validus_keyed_init.
+ * @param   state Pointer to a validus_state object which will contain the
+ *                keyed fingerprint upon success.
+ * @param   data  The message. May be NULL if `len` is zero.
+ * @param   len   Length of `data` in octets.
+ * @returns bool  `true` if input parameters are valid, `false` otherwise.
+ */
+bool validus_keyed_hash(const validus_keyed* keyed, validus_state* state,
+    const void* data, size_t len);
+
+/**
+ * @brief Begins an incremental keyed fingerprint.
+ *
+ * `stream` is set to the keyed inner midstate; write the message to it with
+ * ::validus_stream_write, then call ::validus_keyed_finalize.
+ *
+ * @param   keyed  Pointer to a validus_keyed object prepared by ::validus_keyed_init.
+ * @param   stream Pointer to the validus_stream object to begin.
+ * @returns bool   `true` if input parameters are valid, `false` otherwise.
+ */
+bool validus_keyed_start(const validus_keyed* keyed, validus_stream* stream);
+
+/**
+ * @brief Finishes an incremental keyed fingerprint.
+ *
+ * @param   keyed  The validus_keyed object passed to ::validus_keyed_start.
+ * @param   stream Pointer to the validus_stream object; `stream->state` holds
+ *                 the keyed fingerprint upon success.
+ * @returns bool   `true` if input parameters are valid, `false` otherwise.
+ */
+bool validus_keyed_finalize(const validus_keyed* keyed, validus_stream* stream);
+
+/**
+ * @brief Erases the key material held by a validus_keyed object.
+ *
+ * @param keyed Pointer to the validus_keyed object to erase.
+ */
+void validus_keyed_wipe(validus_keyed* keyed);
+
+/**
+ * @brief Compares two fingerprints in constant time.
+ *
+ * Unlike ::validus_compare, the time taken does not depend upon where (or
+ * whether) the fingerprints differ, so it is safe for checking keyed
+ * fingerprints.
+ *
+ * @param   one  Pointer to a validus_state to compare for equality.
+ * @param   two  Pointer to a validus_state to compare for equality.
+ * @returns bool `true` if both fingerprints are identical, `false` otherwise.
+ */
+bool validus_compare_ct(const validus_state* one, const validus_state* two);
+
+/**
+ * @brief Recursively hashes every regular file beneath a directory.
+ *
+ * The walker reads each directory with getdents64 (readdir elsewhere), opens
+ * subdirectories relative to their parent with openat, and hands the files to
+ * a work-stealing pool. Results are reported to `fn`, on the calling thread,
+ * in a deterministic order: depth-first, with the entries of each directory
+ * sorted by name. Special files (FIFOs, sockets, devices) are skipped.
+ *
+ * @note Not supported on Windows.
+ *
+ * @param   dir       Absolute or relative pathname of the directory to walk.
+ * @param   dir_flags Bitwise OR of VALIDUS_DIR_* flags, or zero.
+ * @param   io        Options for reading each file; NULL for the defaults.
+ * @param   threads   Number of worker threads; 0 to use one per CPU.
+ * @param   fn        The function to receive each file's result.
+ * @param   ctx       Passed through to `fn`.
+ * @returns bool      `true` if every directory and file was read
+ *                    successfully, `false` otherwise.
+ */
+bool validus_hash_dir(const char* dir, uint32_t dir_flags, const validus_io_options* io,
+    size_t threads, validus_dir_fn fn, void* ctx);
+
+/**
+ * @brief Verifies the files listed in a manifest.
+ *
+ * The manifest has one entry per line: a fingerprint (VALIDUS_FP_FMT_SPEC, in
+ * either case), whitespace, and a path (relative to the working directory),
+ * as printed by `validus -r`. Blank lines and lines beginning with '#' are
+ * ignored. Regular manifests are memory-mapped.
+ *
+ * Entries are grouped by device and, within a device, ordered by inode. The
+ * files are hashed in parallel, but each rotational device is read by no more
+ * than VALIDUS_VERIFY_HDD_READERS threads at a time, so that spinning disks
+ * are read (mostly) sequentially.
+ *
+ * @param   manifest Absolute or relative pathname of the manifest.
+ * @param   io_flags Bitwise OR of VALIDUS_IO_* flags for reading each file.
+ * @param   threads  Number of worker threads; 0 to use one per CPU.
+ * @param   fn       The function to receive each failed entry, in manifest
+ *                   order; may be NULL.
+ * @param   ctx      Passed through to `fn`.
+ * @param   totals   Receives the totals; may be NULL.
+ * @returns bool     `true` if the manifest was read, was well-formed and every
+ *                   entry passed, `false` otherwise.
+ */
+bool validus_verify_manifest(const char* manifest, uint32_t io_flags, size_t threads,
+    validus_verify_fn fn, void* ctx, validus_verify_totals* totals);
+
+/**
+ * @brief Retrieves the hot-path counters.
+ *
+ * The counters are only collected if Validus was built with the VALIDUS_STATS
+ * CMake option; otherwise, they cost nothing, and read as zero.
+ *
+ * @param   stats Receives the counters.
+ * @returns bool  `true` if counters are collected (and `stats` is not NULL),
+ *                `false` otherwise.
+ */
+bool validus_stats_get(validus_stats* stats);
+
+/**
+ * @brief Returns the number of CPUs available to this process.
+ *
+ * On Linux, this is the size of the process's CPU affinity mask, further
+ * limited by any cgroup (v1 or v2) CPU bandwidth quota.
+ *
+ * @returns size_t The number of usable CPUs (at least 1).
+ */
+size_t validus_cpu_count(void);
+
 /**
  * @brief Converts a validus_state to hexadecimal string form.
  *
@@ -125,16 +673,28 @@ bool validus_hash_file(validus_state *state, const char *file);
  */
 bool validus_state_to_string(const validus_state *state, char *out, size_t len);
 
+/**
+ * @brief Parses a fingerprint in the form produced by ::validus_state_to_string.
+ *
+ * @param   state Pointer to a validus_state to receive the fingerprint.
+ * @param   str   The string to parse; its first 48 characters must be
+ *                hexadecimal digits (in either case). Anything after them is
+ *                ignored.
+ * @returns bool  `true` if input parameters are valid, and parsing succeeds,
+ *                `false` otherwise.
+ */
+bool validus_state_from_string(validus_state* state, const char* str);
+
 /** @} */
 
 ////////////////////////// internal functions //////////////////////////////////
 
-/** A platform-dependent timer used for performance measurement. */
+/** A platform-dependent monotonic timer used for performance measurement. */
 typedef struct {
 # if defined(__WIN__)
-    FILETIME ft;        /**< The timer type on Windows. */
+    LARGE_INTEGER counter; /**< The timer type on Windows. */
 # else
-    struct timespec ts; /**< The timer type on *nix */
+    struct timespec ts;    /**< The timer type on *nix */
 # endif
 } validus_timer;
 
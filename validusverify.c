@@ -0,0 +1,442 @@
+/**
+ * @file validusverify.c
+ * @brief Implementation of manifest verification.
+ *
+ * @author    Ryan M. Lederman \<lederman@gmail.com\>
+ * @date      2004-2025
+ * @version   1.0.5
+ * @copyright The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "validusio.h"
+#include "validuspool.h"
+
+#if !defined(__WIN__)
+# include <sys/stat.h>
+# if defined(__linux__)
+#  include <sys/sysmacros.h>
+# endif
+#endif
+
+typedef enum {
+    VALIDUS_VERIFY_PENDING = 0,
+    VALIDUS_VERIFY_PASSED,
+    VALIDUS_VERIFY_MISMATCHED,
+    VALIDUS_VERIFY_UNREADABLE
+} validus_verify_status;
+
+typedef struct {
+    const char* path;
+    validus_state expected;
+    validus_state actual;
+    uint64_t dev;
+    uint64_t ino;
+    validus_verify_status status;
+} validus_verify_entry;
+
+/** The entries on one device: validus_verify_job::order[next, end). */
+typedef struct {
+    size_t next;
+    size_t end;
+    size_t active; /**< Readers currently hashing entries of this group. */
+    size_t limit;  /**< The most readers allowed at once. */
+} validus_verify_group;
+
+typedef struct {
+    validus_verify_entry* entries;
+    size_t count;
+    validus_verify_entry** order; /**< Entries to hash, by (device, inode). */
+    size_t ordered;
+    validus_verify_group* groups;
+    size_t ngroups;
+    uint32_t io_flags;
+    validus_mutex lock;
+    validus_cond cond; /**< Signalled when a reader finishes an entry. */
+} validus_verify_job;
+
+/** Returns whether the block device `dev` is rotational; false if unknown. */
+static bool _validus_dev_rotational(uint64_t dev)
+{
+#if defined(__linux__)
+    static const char* const formats[] = {
+        "/sys/dev/block/%u:%u/queue/rotational",
+        "/sys/dev/block/%u:%u/../queue/rotational" /* partitions. */
+    };
+
+    for (size_t n = 0; n < sizeof(formats) / sizeof(formats[0]); n++) {
+        char file[128] = {0};
+        (void)snprintf(file, sizeof(file), formats[n], major((dev_t)dev), minor((dev_t)dev));
+
+        FILE* fp = fopen(file, "r");
+        if (!fp)
+            continue;
+
+        int rotational = fgetc(fp);
+        (void)fclose(fp);
+        return '1' == rotational;
+    }
+#else
+    (void)dev;
+#endif
+    return false;
+}
+
+static void _validus_verify_stat(void* ctx, size_t worker, size_t idx)
+{
+    validus_verify_job* job     = (validus_verify_job*)ctx;
+    validus_verify_entry* entry = &job->entries[idx];
+    (void)worker;
+
+#if !defined(__WIN__)
+    struct stat st;
+    if (0 != stat(entry->path, &st)) {
+        fprintf(stderr, "failed to stat '%s': %d\n", entry->path, errno);
+        entry->status = VALIDUS_VERIFY_UNREADABLE;
+        return;
+    }
+
+    entry->dev = (uint64_t)st.st_dev;
+    entry->ino = (uint64_t)st.st_ino;
+#else
+    (void)entry;
+#endif
+}
+
+static int _validus_verify_cmp(const void* lhs, const void* rhs)
+{
+    const validus_verify_entry* one = *(const validus_verify_entry* const*)lhs;
+    const validus_verify_entry* two = *(const validus_verify_entry* const*)rhs;
+
+    if (one->dev != two->dev)
+        return one->dev < two->dev ? -1 : 1;
+    if (one->ino != two->ino)
+        return one->ino < two->ino ? -1 : 1;
+    return one < two ? -1 : one > two ? 1 : 0;
+}
+
+static void _validus_verify_reader(void* ctx, size_t worker, size_t idx)
+{
+    validus_verify_job* job = (validus_verify_job*)ctx;
+    (void)worker;
+    (void)idx;
+
+    for (;;) {
+        validus_verify_group* group = NULL;
+
+        _validus_mutex_lock(&job->lock);
+        for (;;) {
+            bool pending = false;
+
+            /* the least busy device with entries left, and room for a reader. */
+            for (size_t n = 0; n < job->ngroups; n++) {
+                validus_verify_group* g = &job->groups[n];
+                if (g->next == g->end)
+                    continue;
+                pending = true;
+                if (g->active < g->limit && (!group || g->active < group->active))
+                    group = g;
+            }
+
+            if (group || !pending)
+                break;
+
+            _validus_cond_wait(&job->cond, &job->lock);
+        }
+
+        if (!group) {
+            _validus_mutex_unlock(&job->lock);
+            return;
+        }
+
+        validus_verify_entry* entry = job->order[group->next++];
+        group->active++;
+        _validus_mutex_unlock(&job->lock);
+
+        if (!validus_hash_file_ex(&entry->actual, entry->path, job->io_flags))
+            entry->status = VALIDUS_VERIFY_UNREADABLE;
+        else if (validus_compare(&entry->actual, &entry->expected))
+            entry->status = VALIDUS_VERIFY_PASSED;
+        else
+            entry->status = VALIDUS_VERIFY_MISMATCHED;
+
+        _validus_mutex_lock(&job->lock);
+        group->active--;
+        _validus_cond_broadcast(&job->cond);
+        _validus_mutex_unlock(&job->lock);
+    }
+}
+
+/** Decodes the escaped path from `cur` to `last` (`\\`, `\n` and `\r`) into
+ * `out`; false if it has any other escape. */
+static bool _validus_verify_unescape(char* out, const char* cur, const char* last, size_t* len)
+{
+    size_t n = 0;
+
+    for (; cur < last; cur++) {
+        if ('\\' != *cur) {
+            out[n++] = *cur;
+            continue;
+        }
+
+        if (++cur == last)
+            return false;
+
+        switch (*cur) {
+            case '\\': out[n++] = '\\'; break;
+            case 'n': out[n++] = '\n'; break;
+            case 'r': out[n++] = '\r'; break;
+            default: return false;
+        }
+    }
+
+    *len = n;
+    return true;
+}
+
+/** Parses the manifest `text` into entries, whose paths are copied to `paths`. */
+static bool _validus_verify_parse(validus_verify_job* job, const char* text, size_t len,
+    char* paths, validus_verify_totals* totals)
+{
+    size_t cap   = 0;
+    size_t line  = 0;
+    const char* end = text + len;
+
+    for (const char* pos = text; pos < end; line++) {
+        const char* eol = memchr(pos, '\n', (size_t)(end - pos));
+        if (!eol)
+            eol = end;
+
+        const char* cur  = pos;
+        const char* last = eol;
+        pos              = eol + 1;
+
+        if (last > cur && '\r' == last[-1])
+            last--;
+
+        if (cur == last || '#' == *cur)
+            continue;
+
+        /* as with sha256sum, a leading backslash means the path is escaped. */
+        bool escaped = '\\' == *cur;
+        if (escaped)
+            cur++;
+
+        validus_state expected;
+        if (last - cur < 50 || !validus_state_from_string(&expected, cur) ||
+            (' ' != cur[48] && '\t' != cur[48])) {
+            fprintf(stderr, "malformed manifest entry at line %zu\n", line + 1);
+            totals->malformed++;
+            continue;
+        }
+
+        /* a '*' marks binary mode in the sha*sum format; it means nothing here. */
+        cur += 48;
+        while (cur < last && (' ' == *cur || '\t' == *cur))
+            cur++;
+        if (cur < last && '*' == *cur)
+            cur++;
+
+        if (cur == last) {
+            fprintf(stderr, "malformed manifest entry at line %zu\n", line + 1);
+            totals->malformed++;
+            continue;
+        }
+
+        if (job->count == cap) {
+            cap = cap ? cap * 2 : 1024;
+            validus_verify_entry* entries = realloc(job->entries, cap * sizeof(validus_verify_entry));
+            if (!entries) {
+                fprintf(stderr, "failed to allocate memory for %zu entries: %d\n", cap, errno);
+                return false;
+            }
+            job->entries = entries;
+        }
+
+        size_t path_len = 0;
+        if (!escaped) {
+            path_len = (size_t)(last - cur);
+            memcpy(paths, cur, path_len);
+        } else if (!_validus_verify_unescape(paths, cur, last, &path_len)) {
+            fprintf(stderr, "malformed manifest entry at line %zu\n", line + 1);
+            totals->malformed++;
+            continue;
+        }
+        paths[path_len] = '\0';
+
+        validus_verify_entry* entry = &job->entries[job->count++];
+        memset(entry, 0, sizeof(validus_verify_entry));
+        entry->path     = paths;
+        entry->expected = expected;
+        paths += path_len + 1;
+    }
+
+    return true;
+}
+
+/** Reads the whole of `fd`, for manifests that cannot be mapped. */
+static char* _validus_verify_slurp(validus_fd fd, size_t* len)
+{
+    size_t size = 0, cap = VALIDUS_FILE_BLOCKSIZE;
+    char* buf   = malloc(cap);
+
+    while (buf) {
+        if (size == cap) {
+            char* grown = realloc(buf, cap * 2);
+            if (!grown)
+                break;
+            buf  = grown;
+            cap *= 2;
+        }
+
+        size_t got = 0;
+        if (!_validus_file_read(fd, buf + size, cap - size, &got))
+            break;
+        if (0 == got) {
+            *len = size;
+            return buf;
+        }
+        size += got;
+    }
+
+    free(buf);
+    return NULL;
+}
+
+bool validus_verify_manifest(const char* manifest, uint32_t io_flags, size_t threads,
+    validus_verify_fn fn, void* ctx, validus_verify_totals* totals)
+{
+    if (!manifest || !*manifest)
+        return false;
+
+    validus_verify_totals local = {0};
+    if (!totals)
+        totals = &local;
+    memset(totals, 0, sizeof(validus_verify_totals));
+
+    validus_fd fd = _validus_file_open(manifest, 0U);
+    if (VALIDUS_INVALID_FD == fd)
+        return false;
+
+    uint64_t size   = 0;
+    bool regular    = false;
+    const char* map = NULL;
+    char* text      = NULL;
+    size_t len      = 0;
+
+    if (_validus_file_stat(fd, &size, &regular) && regular && size > 0 && size <= SIZE_MAX) {
+        len = (size_t)size;
+        map = _validus_file_map(fd, 0, len, 0U);
+    }
+
+    if (!map) {
+        text = _validus_verify_slurp(fd, &len);
+        if (!text) {
+            fprintf(stderr, "failed to read from file '%s'\n", manifest);
+            _validus_file_close(fd);
+            return false;
+        }
+    }
+
+    _validus_file_close(fd);
+
+    validus_verify_job job = {0};
+    job.io_flags = io_flags;
+
+    /* every path, with its terminator, is no longer than its line. */
+    char* paths = malloc(len + 1);
+    bool ok     = paths && _validus_verify_parse(&job, map ? map : text, len, paths, totals);
+
+    if (map)
+        _validus_file_unmap(map, len);
+    free(text);
+
+    if (!paths)
+        fprintf(stderr, "failed to allocate %zu octets of heap memory: %d\n", len + 1, errno);
+
+    if (ok && job.count > 0) {
+        job.order  = calloc(job.count, sizeof(validus_verify_entry*));
+        job.groups = calloc(job.count, sizeof(validus_verify_group));
+        ok         = job.order && job.groups;
+
+        if (!ok)
+            fprintf(stderr, "failed to allocate memory for %zu entries: %d\n", job.count, errno);
+    }
+
+    if (ok && job.count > 0) {
+        if (0 == threads)
+            threads = validus_cpu_count();
+
+        ok = _validus_parallel_for(threads, job.count, &_validus_verify_stat, &job);
+
+        for (size_t n = 0; ok && n < job.count; n++) {
+            if (VALIDUS_VERIFY_PENDING == job.entries[n].status)
+                job.order[job.ordered++] = &job.entries[n];
+        }
+
+        qsort(job.order, job.ordered, sizeof(validus_verify_entry*), &_validus_verify_cmp);
+
+        for (size_t n = 0; n < job.ordered; n++) {
+            if (0 == n || job.order[n]->dev != job.order[n - 1]->dev) {
+                validus_verify_group* group = &job.groups[job.ngroups++];
+                group->next  = n;
+                group->limit = _validus_dev_rotational(job.order[n]->dev)
+                    ? VALIDUS_VERIFY_HDD_READERS : threads;
+            }
+            job.groups[job.ngroups - 1].end = n + 1;
+        }
+
+        if (ok && job.ordered > 0) {
+            _validus_mutex_init(&job.lock);
+            _validus_cond_init(&job.cond);
+            ok = _validus_parallel_for(threads, threads, &_validus_verify_reader, &job);
+            _validus_cond_destroy(&job.cond);
+            _validus_mutex_destroy(&job.lock);
+        }
+    }
+
+    if (ok) {
+        totals->entries = job.count;
+
+        for (size_t n = 0; n < job.count; n++) {
+            const validus_verify_entry* entry = &job.entries[n];
+            switch (entry->status) {
+                case VALIDUS_VERIFY_PASSED:
+                    totals->passed++;
+                    continue;
+                case VALIDUS_VERIFY_MISMATCHED:
+                    totals->mismatched++;
+                    break;
+                default:
+                    totals->unreadable++;
+                    break;
+            }
+
+            if (fn)
+                fn(ctx, entry->path, &entry->expected,
+                    VALIDUS_VERIFY_MISMATCHED == entry->status ? &entry->actual : NULL);
+        }
+    }
+
+    free(job.groups);
+    free(job.order);
+    free(job.entries);
+    free(paths);
+
+    return ok && totals->passed == totals->entries && 0 == totals->malformed;
+}